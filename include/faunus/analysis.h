@@ -13,6 +13,8 @@
 #include <Eigen/Core>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <functional>
 
 namespace Faunus
@@ -74,6 +76,8 @@ namespace Faunus
                 string info();       //!< Print info and results
                 void test( UnitTest & );//!< Perform unit test
                 void sample();       //!< Sample event.
+                bool due();          //!< Advance step counter; true if sampling is due
+                void run();          //!< Sample now, regardless of interval
                 Tmjson json();       //!< Get info and results as json object
         };
 
@@ -592,10 +596,10 @@ namespace Faunus
                     double tot, ii, id, iq, dd, mucorr;
                     unsigned long int cnt;
 
-                    data() : cnt(0) {}
+                    data() : tot(0), ii(0), id(0), iq(0), dd(0), mucorr(0), cnt(0) {}
                 };
 
-                std::map<int, data> m; // slow, but OK for infrequent sampling
+                BinnedTable<double, data> m; // averages as a function of cm-cm distance
 
                 /**
                  * @brief Calculates quadrupole moment tensor (not traceless)
@@ -662,7 +666,6 @@ namespace Faunus
                     // multipolar energy
                     coulomb.setSpace(spc);
                     data d;
-                    d.cnt++;
                     d.tot = g2g(spc, g1, g2); // exact el. energy
                     d.ii = a.charge * b.charge * rinv; // ion-ion, etc.
                     d.id = q2mu(a.charge*b.muscalar(),b.mu(),b.charge*a.muscalar(),a.mu(),r);
@@ -671,20 +674,14 @@ namespace Faunus
                     d.mucorr = a.mu().dot(b.mu());
 
                     // add to grand average
-                    int key = to_bin(1 / rinv, dr);
-                    auto it = m.find(key);
-                    if ( it == m.end())
-                        m[key] = d;
-                    else
-                    {
-                        it->second.cnt++;
-                        it->second.ii += d.ii;
-                        it->second.id += d.id;
-                        it->second.iq += d.iq;
-                        it->second.dd += d.dd;
-                        it->second.tot += d.tot;
-                        it->second.mucorr += d.mucorr;
-                    }
+                    auto &e = m(1 / rinv);
+                    e.cnt++;
+                    e.ii += d.ii;
+                    e.id += d.id;
+                    e.iq += d.iq;
+                    e.dd += d.dd;
+                    e.tot += d.tot;
+                    e.mucorr += d.mucorr;
                 }
 
                 /** @brief Save multipole distribution to disk */
@@ -702,18 +699,19 @@ namespace Faunus
                             << std::left << setw(w) << "# r/AA" << std::right << setw(w) << "exact"
                             << setw(w) << "total" << setw(w) << "ionion" << setw(w) << "iondip"
                             << setw(w) << "dipdip" << setw(w) << "ionquad" << setw(w) << "mucorr\n";
-                        for ( auto &i : m )
+                        m.forEach( [&](double r, const data &i) {
                             f << std::left
-                                << setw(w) << i.first * dr                  // r
+                                << setw(w) << r                             // r
                                 << std::right
-                                << setw(w) << i.second.tot / i.second.cnt   // exact (already in kT)
-                                << setw(w) << lB * (i.second.ii + i.second.id + i.second.dd + i.second.iq) / i.second.cnt // total
-                                << setw(w) << lB * i.second.ii / i.second.cnt // individual poles...
-                                << setw(w) << lB * i.second.id / i.second.cnt
-                                << setw(w) << lB * i.second.dd / i.second.cnt
-                                << setw(w) << lB * i.second.iq / i.second.cnt
-                                << setw(w) << i.second.mucorr / i.second.cnt
+                                << setw(w) << i.tot / i.cnt   // exact (already in kT)
+                                << setw(w) << lB * (i.ii + i.id + i.dd + i.iq) / i.cnt // total
+                                << setw(w) << lB * i.ii / i.cnt // individual poles...
+                                << setw(w) << lB * i.id / i.cnt
+                                << setw(w) << lB * i.dd / i.cnt
+                                << setw(w) << lB * i.iq / i.cnt
+                                << setw(w) << i.mucorr / i.cnt
                                 << "\n";
+                        } );
                     }
                 }
                 void _sample() override
@@ -748,6 +746,7 @@ namespace Faunus
             {
                 name = "Multipole Distribution";
                 dr = j.value("dr", 0.2);
+                m.setResolution(dr);
                 filename = j.value("file", string("multipole.dat"));
                 if (j.count("groups")==1) {
                     vector<string> names = j["groups"];
@@ -786,6 +785,15 @@ namespace Faunus
          *  `ninsert`  | Number of insertions per sampling event (int)
          *  `nstep`    | Sample every n'th step (int)
          *  `particles`| Atom names to simultaneously insert (array)
+         *  `parallel` | Evaluate insertions on all OpenMP threads (default: false)
+         *
+         * All `ninsert` ghost configurations of a sampling event are generated
+         * as one batch and, if `parallel` is set, their energies are evaluated
+         * concurrently. This requires that `Energybase::all2p()` and `p2p()` of
+         * the Hamiltonian are free of side effects. To let each ghost see only
+         * neighbours within the cutoff, use `Energy::NonbondedCellList`; terms
+         * beyond the cutoff such as Ewald reciprocal space enter via their own
+         * `all2p()`.
          */
         template<class Tspace>
             class Widom : public AnalysisBase
@@ -833,33 +841,64 @@ namespace Faunus
                     test("widom_muex", muex());
                 }
 
+                /** @brief Energy of ghost set `k` in the batch with the system and itself */
+                double ghostEnergy( int k ) const
+                {
+                    int n = g.size();
+                    auto first = batch.begin() + k * n;
+                    double du = 0;
+                    for ( int i = 0; i < n; i++ )
+                        du += pot.all2p(spc.p, first[i]);  // energy with all particles in space
+                    for ( int i = 0; i < n - 1; i++ )
+                        for ( int j = i + 1; j < n; j++ )
+                            du += pot.p2p(first[i], first[j]);// energy between ghost particles
+                    return du;
+                }
+
                 void _sample() override
                 {
-                    int n = g.size(), cnt=ghostin;
-                    if ( n > 0 )
-                        while ( cnt-- > 0 )
+                    int n = g.size();
+                    if ( n == 0 || ghostin < 1 )
+                        return;
+
+                    // generate all ghost positions up front, in the same order as
+                    // one-by-one insertion so that the random sequence is unchanged
+                    batch.clear();
+                    batch.reserve( ghostin * n );
+                    for ( int k = 0; k < ghostin; k++ )
+                        for ( auto i : g )
                         {
-                            double du = 0;
-                            for ( auto &i : g )
-                                spc.geo.randompos(i);     // random ghost positions
-                            for ( auto &i : g )
-                                du += pot.all2p(spc.p, i);  // energy with all particles in space
-                            for ( int i = 0; i < n - 1; i++ )
-                                for ( int j = i + 1; j < n; j++ )
-                                    du += pot.p2p(g[i], g[j]);// energy between ghost particles
-                            expsum += exp(-du);
+                            spc.geo.randompos(i);     // random ghost positions
+                            batch.push_back(i);
                         }
+
+                    // the first set is evaluated serially to let the Hamiltonian
+                    // build lazy structures such as cell lists before threads start
+                    du.resize( ghostin );
+                    du[0] = ghostEnergy(0);
+#pragma omp parallel for schedule(static) if(parallel)
+                    for ( int k = 1; k < ghostin; k++ )
+                        du[k] = ghostEnergy(k);
+
+                    for ( auto u : du )
+                        expsum += exp(-u);
                 }
 
+                typename Tspace::ParticleVector batch; //!< Ghost positions of current sample event
+                std::vector<double> du;                //!< Insertion energies of current sample event
+
             protected:
                 std::vector<Tparticle> g; //!< Pool of ghost particles to insert (simultaneously)
             public:
+                bool parallel;            //!< Evaluate ghost insertions concurrently (OpenMP)
+
                 Widom( Tmjson &j, Energy::Energybase<Tspace> &pot, Tspace &spc ) : spc(spc), pot(pot), AnalysisBase(j)
             {
                 name = "Multi Particle Widom Analysis";
                 cite = "doi:10/dkv4s6";
 
                 ghostin = j.value("ninsert", 10);
+                parallel = j.value("parallel", false);
 
                 if (j.count("particles")>0)
                     if (j["particles"].is_array()) {
@@ -920,6 +959,10 @@ namespace Faunus
          *  `lB`       | Bjerrum length (angstrom)
          *  `ninsert`  | Number of intertions per sampling event
          *  `nstep`    | Sample every n'th step
+         *  `parallel` | Evaluate insertions on all OpenMP threads (default: false)
+         *
+         * As for `Widom`, all insertions of a sampling event are generated as
+         * one batch before their overlaps and potentials are evaluated.
          *
          * @warning Works only for the primitive model
          * @note This is a conversion of the Widom routine found in the `bulk.f`
@@ -949,7 +992,7 @@ namespace Faunus
                 vector <Tvec> chint; //!< charging integrand
                 Tvec chid;          //!< ideal term
                 Tvec expuw;
-                vector<int> ihc, irej;
+                vector<int> ihc;
                 int ghostin;        //< ghost insertions
                 double lB;          //!< Bjerrum length
 
@@ -966,7 +1009,6 @@ namespace Faunus
                     expuw.resize(gspec);
                     chexw.resize(gspec);
                     ihc.resize(gspec);
-                    irej.resize(gspec);
 
                     for ( int i = 0; i < gspec; i++ )
                     {
@@ -1049,74 +1091,96 @@ namespace Faunus
                 }
 
 
-                void _sample() override
+                /**
+                 * @brief Overlap and electric potential of insertion `i` in the batch
+                 *
+                 * For each ghost type `k`, `rej[i*g.size()+k]` is set if it overlaps
+                 * with the system; unless all do, `u[i]` and `cu[i]` receive the
+                 * electric potential and the sum of inverse distances.
+                 */
+                void ghostInsert( int i )
                 {
                     auto &geo = spc.geo;
                     auto &p = spc.p;
-                    if ( !g.empty())
-                        if ( !p.empty())
+                    Tparticle ghost = batch[i];
+                    int n = g.size(), goverlap = 0;
+                    for ( int k = 0; k < n; k++ )
+                    {
+                        ghost.radius = g[k].radius;
+                        size_t j = 0;
+                        while ( j < p.size() && !overlap(ghost, p[j], geo))
+                            j++;
+                        rej[i * n + k] = (j != p.size());
+                        goverlap += rej[i * n + k];
+                    }
+                    u[i] = cu[i] = 0;
+                    if ( goverlap != n )
+                    {
+                        for ( auto &a : p )
                         {
-                            Tparticle ghost;
-                            double u, cu;
-                            for ( int i = 0; i < ghostin; i++ )
-                            {
-                                geo.randompos(ghost);
-                                int goverlap = 0;
-                                for ( size_t k = 0; k < g.size(); k++ )
-                                {
-                                    ghost.radius = g[k].radius;
-                                    irej[k] = 0;
-                                    int j = 0;
-                                    while ( !overlap(ghost, p[j], geo) && j < (int) p.size())
-                                        j++;
-                                    if ( j != (int) p.size())
-                                    {
-                                        ihc[k]++;
-                                        irej[k] = 1;
-                                        goverlap++;
-                                    }
-                                }
+                            double invdi = 1 / geo.dist(ghost, a);
+                            cu[i] += invdi;
+                            u[i] += invdi * a.charge; //elelectric potential (Coulomb only!)
+                        }
+                        cu[i] = cu[i] * lB;
+                        u[i] = u[i] * lB;
+                    }
+                }
 
-                                if ( goverlap != (int) g.size())
-                                {
-                                    cu = 0;
-                                    u = 0;  //elelectric potential (Coulomb only!)
-                                    for ( auto &i : p )
-                                    {
-                                        double invdi = 1 / geo.dist(ghost, i);
-                                        cu += invdi;
-                                        u += invdi * i.charge;
-                                    }
-                                    cu = cu * lB;
-                                    u = u * lB;
-                                    double ew, ewla, ewd;
-                                    for ( size_t k = 0; k < g.size(); k++ )
-                                    {
-                                        if ( irej[k] == 0 )
-                                        {
-                                            expuw[k] += exp(-u * g[k].charge);
-                                            for ( int cint = 0; cint < 11; cint++ )
-                                            {
-                                                ew = g[k].charge *
-                                                    (u - double(cint) * 0.1 * g[k].charge * cu / double(p.size()));
-                                                ewla = ew * double(cint) * 0.1;
-                                                ewd = exp(-ewla);
-                                                ewden[k][cint] += ewd;
-                                                ewnom[k][cint] += ew * ewd;
-                                            }
-                                        }
-                                    }
-                                }
+                void _sample() override
+                {
+                    auto &p = spc.p;
+                    int n = g.size();
+                    if ( n == 0 || p.empty() || ghostin < 1 )
+                        return;
+
+                    // positions are generated in the order of one-by-one insertion
+                    batch.resize(ghostin);
+                    for ( auto &ghost : batch )
+                        spc.geo.randompos(ghost);
+
+                    rej.resize(ghostin * n);
+                    u.resize(ghostin);
+                    cu.resize(ghostin);
+#pragma omp parallel for schedule(static) if(parallel)
+                    for ( int i = 0; i < ghostin; i++ )
+                        ghostInsert(i);
+
+                    // accumulate in insertion order
+                    double ew, ewla, ewd;
+                    for ( int i = 0; i < ghostin; i++ )
+                        for ( int k = 0; k < n; k++ )
+                        {
+                            if ( rej[i * n + k] )
+                            {
+                                ihc[k]++;
+                                continue;
+                            }
+                            expuw[k] += exp(-u[i] * g[k].charge);
+                            for ( int cint = 0; cint < 11; cint++ )
+                            {
+                                ew = g[k].charge *
+                                    (u[i] - double(cint) * 0.1 * g[k].charge * cu[i] / double(p.size()));
+                                ewla = ew * double(cint) * 0.1;
+                                ewd = exp(-ewla);
+                                ewden[k][cint] += ewd;
+                                ewnom[k][cint] += ew * ewd;
                             }
                         }
                 }
 
+                typename Tspace::ParticleVector batch; //!< Ghost positions of current sample event
+                vector<char> rej;                      //!< Overlap of each ghost type for each insertion
+                Tvec u, cu;                            //!< Electric potential and sum of 1/r for each insertion
+
             public:
+                bool parallel; //!< Evaluate insertions concurrently (OpenMP)
 
                 WidomScaled( Tmjson &j, Tspace &spc ) : spc(spc), AnalysisBase(j)
             {
                 lB = j.value("lB", 7.0);
                 ghostin = j.value("ninsert", 10);
+                parallel = j.value("parallel", false);
                 name = "Single particle Widom insertion w. charge scaling";
                 cite = "doi:10/ft9bv9 + doi:10/dkv4s6";
 
@@ -1524,7 +1588,7 @@ namespace Faunus
                 int id;
                 double zmin, zmax, dz, area;
                 Tspace *spc;
-                Table2D<double, Average<double> > data;
+                BinnedTable<double, Average<double> > data;
 
                 inline string _info() override
                 {
@@ -1624,7 +1688,12 @@ namespace Faunus
         /**
          * @brief Write XTC trajectory file
          *
-         * JSON keywords: `nstep`, `file`
+         * JSON keywords: `nstep`, `file`, `async` (default: false),
+         * `queue` (default: 1).
+         *
+         * If `async` is true, frames are compressed and written by
+         * `FormatXTCAsync` in a background thread with at most `queue`
+         * pending frames (0=unbounded).
          */
         template<class Tspace>
             class XTCtraj : public AnalysisBase
@@ -1632,13 +1701,20 @@ namespace Faunus
             private:
 
                 FormatXTC xtc;
+                std::shared_ptr<FormatXTCAsync> axtc;
                 Tspace *spc;
                 string filename;
 
                 void _sample() override
                 {
-                    xtc.setbox(spc->geo.inscribe().len);
-                    xtc.save(filename, spc->p);
+                    if ( axtc ) {
+                        axtc->setbox(spc->geo.inscribe().len);
+                        axtc->save(filename, spc->p);
+                    }
+                    else {
+                        xtc.setbox(spc->geo.inscribe().len);
+                        xtc.save(filename, spc->p);
+                    }
                 }
 
                 string _info() override
@@ -1657,6 +1733,8 @@ namespace Faunus
                 name = "XTC trajectory reporter";
                 filename = j.at("file");
                 cite = "http://manual.gromacs.org/online/xtc.html";
+                if ( j.value("async", false) )
+                    axtc = std::make_shared<FormatXTCAsync>(1e6, j.value("queue", 1));
             }
         };
 
@@ -1702,6 +1780,7 @@ namespace Faunus
                     Point dir;
                     double dV;
                     bool fullenergy;
+                    Energy::RunningEnergy *running;
                     Average<double> duexp; // < exp(-du/kT) >
 
                     void scale( double Vold, double Vnew )
@@ -1738,7 +1817,7 @@ namespace Faunus
                         double Vold = spc->geo.getVolume();
                         double Vnew = Vold + dV;
 
-                        double uold = energy(spc->p);
+                        double uold = (fullenergy && running != nullptr) ? running->current() : energy(spc->p);
                         scale(Vold, Vnew);
                         double unew = energy(spc->trial);
                         duexp += exp(-(uold - unew));
@@ -1749,8 +1828,8 @@ namespace Faunus
                         spc->geo.setVolume(Vold);
                         pot->setSpace(*spc);
 
-                        assert(
-                                fabs(uold - energy(spc->p)) < 1e-7 && "System improperly restored!");
+                        assert(((running != nullptr && fullenergy) ||
+                                fabs(uold - energy(spc->p)) < 1e-7) && "System improperly restored!");
                     }
 
                     string _info() override
@@ -1782,9 +1861,13 @@ namespace Faunus
                     dV = j.at("dV");
                     dir = {1, 1, 1};  // scale directions
                     fullenergy = j["fullenergy"] | false;
+                    running = nullptr;
                     name = "Virtual Volume Move";
                     cite = "doi:10.1063/1.472721";
                 }
+
+                    /** @brief Take unperturbed energy from e.g. `Move::Propagator::runningEnergy()` if `fullenergy` */
+                    void setRunningEnergy( Energy::RunningEnergy &u ) { running = &u; }
             };
 
         /**
@@ -1802,6 +1885,12 @@ namespace Faunus
          * `dir`         | Inserting direction array. Default [1,1,1]
          * `molecule`    | Name of molecule to insert
          * `ninsert`     | Number of insertions per sample event
+         * `parallel`    | Evaluate insertions on all OpenMP threads (default: false)
+         *
+         * As for `Widom`, all ghost molecules of a sampling event are generated
+         * as one batch and, if `parallel` is set, their energies with the system
+         * are evaluated concurrently. This requires `Energybase::v2v()` to be
+         * free of side effects.
          */
         template<typename Tspace>
             class WidomMolecule : public AnalysisBase
@@ -1814,10 +1903,13 @@ namespace Faunus
                 string molecule;
                 Point dir;
                 int molid;
+                vector<typename Tspace::ParticleVector> batch; // ghost molecules of current sample event
+                vector<double> du;                              // insertion energies of current sample event
 
             public:
                 Average<double> expu;
                 Average<double> rho;
+                bool parallel; //!< Evaluate insertions concurrently (OpenMP)
 
                 void _sample() override
                 {
@@ -1826,12 +1918,22 @@ namespace Faunus
                     rho += spc->numMolecules(molid) / spc->geo.getVolume();
                     rins.dir = dir;
                     rins.checkOverlap = false;
-                    for ( int i = 0; i < ninsert; ++i )
-                    {
-                        auto pin = rins(spc->geo, spc->p, spc->molecule[molid]); // ('spc->molecule' is a vector of molecules
-                        double u = pot->v2v(pin, spc->p); // energy between "ghost molecule" and system in kT
+                    if ( ninsert < 1 )
+                        return;
+                    batch.resize(ninsert);
+                    for ( auto &pin : batch )
+                        pin = rins(spc->geo, spc->p, spc->molecule[molid]); // ('spc->molecule' is a vector of molecules
+
+                    // energy between "ghost molecule" and system in kT; the first
+                    // is evaluated serially to let lazy structures be built
+                    du.resize(ninsert);
+                    du[0] = pot->v2v(batch[0], spc->p);
+#pragma omp parallel for schedule(static) if(parallel)
+                    for ( int i = 1; i < ninsert; ++i )
+                        du[i] = pot->v2v(batch[i], spc->p);
+
+                    for ( auto u : du )
                         expu += exp(-u); // widom average
-                    }
                 }
 
                 inline string _info() override
@@ -1882,6 +1984,7 @@ namespace Faunus
             {
                 name = "Widom Molecule";
                 ninsert = j.at("ninsert");
+                parallel = j.value("parallel", false);
                 dir << j.value("dir", vector<double>({1,1,1}) );  // magic!
                 molecule = j.at("molecule");
                 // look up the id of the molecule that we want to insert
@@ -2013,6 +2116,224 @@ namespace Faunus
             }
         };
 
+        /**
+         * @brief Single-pass pair distance sampler for several type pairs
+         *
+         * Sample sets are defined by two types, a bin width and an optional
+         * maximum distance. A call to `sample()` loops once over the pairs of
+         * all sets, using per-type index lists, and bins the distances in
+         * fixed-width arrays where bin `k` counts pairs with `round(r/dr)=k`.
+         * Pairs are distributed over OpenMP threads that accumulate privately
+         * before merging. If all sets have a finite `rmax` and the geometry is
+         * cuboidal, only neighbouring cells of a `Geometry::CellList` are
+         * visited. Types are arbitrary non-negative integers, e.g. atom or
+         * molecule id's.
+         *
+         * Example:
+         *
+         *     PairSampler rdf;
+         *     int s = rdf.add( atom["Na"].id, atom["Cl"].id, 0.1 );
+         *     rdf.sample( spc.geo, spc.p, [&](int i) { return spc.p[i].id; } );
+         *     rdf.addTo( s, table ); // table(r) += counts
+         */
+        class PairSampler
+        {
+            private:
+                struct Set
+                {
+                    int type1, type2;
+                    double dr, rmax;
+                };
+
+                struct TypePair
+                {
+                    int type1, type2;
+                    std::vector<int> sets;       // sample sets for this type pair
+                };
+
+                std::vector<Set> sets;
+                std::vector<TypePair> typepairs;
+                std::vector<std::vector<double>> hist;   // histogram of each set
+                std::map<int, std::vector<int>> index;   // particle index of each type
+                std::map<int, std::vector<Point>> pos;   // positions of each type (cell lists only)
+                std::map<int, Geometry::CellList> cells; // cell list of each type
+                bool usecells;
+
+                template<class Tgeometry>
+                void buildCells( const Tgeometry &geo, double rc, std::true_type )
+                {
+                    for ( auto &i : pos )
+                    {
+                        auto &c = cells[i.first];
+                        c.setGeometry(geo, rc);
+                        c.build(i.second);
+                    }
+                }
+
+                template<class Tgeometry>
+                void buildCells( const Tgeometry &, double, std::false_type ) { usecells = false; }
+
+                /** @brief Sort particles by type and build cell lists if possible */
+                template<class Tgeometry, class Tpvec, class Ttype>
+                void prepare( const Tgeometry &geo, const Tpvec &p, Ttype type )
+                {
+                    double rc = 0;
+                    usecells = true;
+                    for ( auto &s : sets )
+                    {
+                        rc = std::max(rc, s.rmax);
+                        usecells = usecells && std::isfinite(s.rmax);
+                    }
+                    for ( auto &i : index )
+                        i.second.clear();
+                    for ( int i = 0; i < (int) p.size(); i++ )
+                    {
+                        auto it = index.find(type(i));
+                        if ( it != index.end())
+                            it->second.push_back(i);
+                    }
+                    if ( usecells )
+                    {
+                        for ( auto &i : index )
+                        {
+                            auto &v = pos[i.first];
+                            v.clear();
+                            for ( auto j : i.second )
+                                v.push_back(p[j]);
+                        }
+                        buildCells(geo, rc, std::is_base_of<Geometry::Cuboid, Tgeometry>());
+                    }
+                }
+
+                /**
+                 * @brief Call `f(set, i, j, r)` for all pairs of all sets
+                 *
+                 * When called within an OpenMP parallel region the outer loop is
+                 * shared among threads.
+                 */
+                template<class Tgeometry, class Tpvec, class Tfunction>
+                void enumerate( const Tgeometry &geo, const Tpvec &p, Tfunction f ) const
+                {
+                    for ( auto &tp : typepairs )
+                    {
+                        auto &A = index.at(tp.type1);
+                        auto &B = index.at(tp.type2);
+                        bool same = (tp.type1 == tp.type2);
+                        auto pair = [&]( int i, int j ) {
+                            double r2 = geo.sqdist(p[i], p[j]);
+                            for ( auto s : tp.sets )
+                                if ( r2 <= sets[s].rmax * sets[s].rmax )
+                                    f(s, i, j, std::sqrt(r2));
+                        };
+#pragma omp for schedule(dynamic, 16)
+                        for ( int a = 0; a < (int) A.size(); a++ )
+                        {
+                            if ( usecells )
+                                cells.at(tp.type2).forNeighbours(p[A[a]], [&]( int b ) {
+                                    if ( !same || b > a )
+                                        pair(A[a], B[b]);
+                                });
+                            else
+                                for ( int b = (same ? a + 1 : 0); b < (int) B.size(); b++ )
+                                    pair(A[a], B[b]);
+                        }
+                    }
+                }
+
+            public:
+                bool parallel = true; //!< Distribute pairs over OpenMP threads in `sample()`
+
+                /**
+                 * @brief Add sample set and return its index
+                 * @param type1 First type
+                 * @param type2 Second type (may equal `type1`)
+                 * @param dr Bin width
+                 * @param rmax Maximum distance to sample (default: no limit)
+                 */
+                int add( int type1, int type2, double dr, double rmax = pc::infty )
+                {
+                    assert(dr > 0 && "bin width must be positive");
+                    int s = sets.size();
+                    sets.push_back({type1, type2, dr, rmax});
+                    hist.resize(sets.size());
+                    index[type1];
+                    index[type2];
+                    auto it = std::find_if(typepairs.begin(), typepairs.end(), [&]( const TypePair &tp ) {
+                        return (tp.type1 == type1 && tp.type2 == type2) || (tp.type1 == type2 && tp.type2 == type1);
+                    });
+                    if ( it == typepairs.end())
+                    {
+                        TypePair tp;
+                        tp.type1 = type1;
+                        tp.type2 = type2;
+                        it = typepairs.insert(typepairs.end(), tp);
+                    }
+                    it->sets.push_back(s);
+                    return s;
+                }
+
+                /**
+                 * @brief Bin all pair distances of all sets
+                 *
+                 * Previous histograms are cleared.
+                 *
+                 * @param geo Geometry used for distances
+                 * @param p Vector of particles or points
+                 * @param type Function returning the type of i'th element in `p`
+                 */
+                template<class Tgeometry, class Tpvec, class Ttype>
+                void sample( const Tgeometry &geo, const Tpvec &p, Ttype type )
+                {
+                    prepare(geo, p, type);
+                    for ( auto &h : hist )
+                        h.clear();
+#pragma omp parallel if(parallel)
+                    {
+                        std::vector<std::vector<double>> h(sets.size());
+                        enumerate(geo, p, [&]( int s, int, int, double r ) {
+                            size_t k = int(r / sets[s].dr + 0.5);
+                            if ( k >= h[s].size())
+                                h[s].resize(k + 1, 0);
+                            h[s][k] += 1;
+                        });
+#pragma omp critical
+                        for ( size_t s = 0; s < h.size(); s++ )
+                        {
+                            if ( h[s].size() > hist[s].size())
+                                hist[s].resize(h[s].size(), 0);
+                            for ( size_t k = 0; k < h[s].size(); k++ )
+                                hist[s][k] += h[s][k];
+                        }
+                    }
+                }
+
+                /**
+                 * @brief Call `f(set, i, j, r)` serially for all pairs of all sets
+                 *
+                 * Use this for pair properties other than counts; `i` and `j`
+                 * refer to elements in `p`.
+                 */
+                template<class Tgeometry, class Tpvec, class Ttype, class Tfunction>
+                void forPairs( const Tgeometry &geo, const Tpvec &p, Ttype type, Tfunction f )
+                {
+                    prepare(geo, p, type);
+                    enumerate(geo, p, f);
+                }
+
+                /** @brief Histogram of last sample for set `s` (index: bin) */
+                const std::vector<double> &histogram( int s ) const { return hist.at(s); }
+
+                /** @brief Add histogram of last sample for set `s` to table, `t(r)+=count` */
+                template<class Ttable>
+                void addTo( int s, Ttable &t ) const
+                {
+                    auto &h = hist.at(s);
+                    for ( size_t k = 0; k < h.size(); k++ )
+                        if ( h[k] > 0 )
+                            t(k * sets[s].dr) += h[k];
+                }
+        };
+
         /**
          * @brief Base class for distribution functions etc.
          */
@@ -2022,17 +2343,18 @@ namespace Faunus
                 struct data {
                     int dim;
                     double dr;
-                    Table2D<double,double> hist;
-                    Table2D<double,Average<double>> hist2;
+                    BinnedTable<double,double> hist;
+                    BinnedTable<double,Average<double>> hist2;
                     string name1, name2, file, file2;
                     double Rhypersphere; // Radius of 2D hypersphere
+                    double rmax;         // Maximum distance to sample
                 };
                 std::vector<data> datavec;        // vector of data sets
                 Average<double> V;                // average volume (angstrom^3)
                 virtual void normalize(data &);
+                void _sample() override;          // calls update() for each data set
             private:
                 virtual void update(data &d)=0;   // called on each defined data set
-                void _sample() override;
                 Tmjson _json() override;
 
             public:
@@ -2068,31 +2390,34 @@ namespace Faunus
          *          { "name1":"Na", "name2":"Na", "dim":3, "dr":0.1, "file":"rdf-nana.dat"}
          *        ]
          *     }
+         *
+         * All pairs are sampled in a single pass using `PairSampler`. An optional
+         * `rmax` for each pair limits the sampled distance and, if given for all
+         * pairs in a cuboidal geometry, enables a cell list.
          */
         template<class Tspace>
             class AtomRDF : public PairFunctionBase {
                 Tspace &spc;
+                PairSampler sampler;
+
+                void _sample() override
+                {
+                    sampler.sample( spc.geo, spc.p, [&](int i) { return int(spc.p[i].id); } );
+                    PairFunctionBase::_sample();
+                }
+
                 void update(data &d) override
                 {
                     V += spc.geo.getVolume( d.dim );
-                    int N = spc.p.size();
-                    int id1 = atom[ d.name1 ].id;
-                    int id2 = atom[ d.name2 ].id;
-                    for (int i=0; i<N-1; i++)
-                        for (int j=i+1; j<N; j++)
-                            if (
-                                    ( spc.p[i].id==id1 && spc.p[j].id==id2 ) ||
-                                    ( spc.p[i].id==id2 && spc.p[j].id==id1 )
-                               )
-                            {
-                                double r = spc.geo.dist( spc.p[i], spc.p[j] );
-                                d.hist(r)++;
-                            }
+                    sampler.addTo( &d - &datavec[0], d.hist );
                 }
 
                 public:
                 AtomRDF( Tmjson j, Tspace &spc ) : PairFunctionBase(j,
-                        "Atomic Pair Distribution Function"), spc(spc) {}
+                        "Atomic Pair Distribution Function"), spc(spc) {
+                    for (auto &d : datavec)
+                        sampler.add( atom[ d.name1 ].id, atom[ d.name2 ].id, d.dr, d.rmax );
+                }
 
                 ~AtomRDF()
                 {
@@ -2107,30 +2432,42 @@ namespace Faunus
         template<class Tspace>
             class MoleculeRDF : public PairFunctionBase {
                 Tspace &spc;
+                PairSampler sampler;
+                std::map<string, int> types; // sampler type of each molecule name
+                vector<Point> cm;            // mass centers of sampled molecules
+                vector<int> type;            // sampler type of each mass center
+
+                void _sample() override
+                {
+                    cm.clear();
+                    type.clear();
+                    for (auto &t : types)
+                        for (auto g : spc.findMolecules( t.first )) {
+                            cm.push_back( g->cm );
+                            type.push_back( t.second );
+                        }
+                    sampler.sample( spc.geo, cm, [&](int i) { return type[i]; } );
+                    PairFunctionBase::_sample();
+                }
+
                 void update(data &d) override
                 {
                     V += spc.geo.getVolume( d.dim );
-                    auto g1 = spc.findMolecules( d.name1 );
-                    auto g2 = spc.findMolecules( d.name2 );
-
-                    if (d.name1!=d.name2)
-                        for (auto i : g1)
-                            for (auto j : g2) {
-                                double r = spc.geo.dist( i->cm, j->cm );
-                                d.hist(r)++;
-                            }
-                    else {
-                        for (int i=0; i<(int)g1.size()-1; i++)
-                            for (int j=i+1; j<(int)g1.size(); j++) {
-                                double r = spc.geo.dist( g1[i]->cm, g1[j]->cm );
-                                d.hist(r)++;
-                            }
-                    }
+                    sampler.addTo( &d - &datavec[0], d.hist );
                 }
 
                 public:
                 MoleculeRDF( Tmjson j, Tspace &spc ) : PairFunctionBase(j,
-                        "Molecular Pair Distribution Function"), spc(spc) {}
+                        "Molecular Pair Distribution Function"), spc(spc) {
+                    for (auto &d : datavec) {
+                        for (auto &name : {d.name1, d.name2})
+                            if (types.count(name)==0) {
+                                int n = types.size();
+                                types[name] = n;
+                            }
+                        sampler.add( types[d.name1], types[d.name2], d.dr, d.rmax );
+                    }
+                }
 
                 ~MoleculeRDF()
                 {
@@ -2188,47 +2525,50 @@ namespace Faunus
             class KirkwoodFactor : public PairFunctionBase {
                 Tspace &spc;
 
-                Table2D<double, double> mucorr_angle;
-                Table2D<double, Average<double> > mucorr_dist;
+                BinnedTable<double, double> mucorr_angle;
+                BinnedTable<double, Average<double> > mucorr_dist;
                 std::vector<data> datavec2;        // vector of data sets, for later use (mucorr_angle,mucorr_dist)
 
-                public:
-                void update( data &d ) override
+                PairSampler sampler;
+
+                // pair terms of all data sets in a single pass
+                void _sample() override
                 {
-                    int N = spc.p.size() - 1;
-                    int id1 = atom[ d.name1 ].id;
-                    int id2 = atom[ d.name2 ].id;
-                    for ( int i = 0; i < N; i++ )
-                    {
-                        if ( spc.p[i].id==id1 || spc.p[i].id==id2 )
-                            d.hist(0) += spc.p[i].mu().dot(spc.p[i].mu()) * spc.p[i].muscalar() * spc.p[i].muscalar();
-                        for ( int j = i + 1.; j < N + 1; j++ )
-                        {
-                            if ( ( spc.p[i].id==id1 && spc.p[j].id==id2 ) || ( spc.p[i].id==id2 && spc.p[j].id==id1 ) )
-                            {
-                                double r = spc.geo.dist(spc.p[i], spc.p[j]);
+                    sampler.forPairs( spc.geo, spc.p, [&](int i) { return int(spc.p[i].id); },
+                            [&](int s, int i, int j, double r) {
+                                auto &d = datavec[s];
                                 double sca = spc.p[i].mu().dot(spc.p[j].mu());
                                 mucorr_angle(sca) += 1.;
                                 d.hist2(r) += sca;
                                 mucorr_dist(r) += 0.5 * (3 * sca * sca - 1.);
                                 d.hist(r) += 2 * sca * spc.p[i].muscalar() * spc.p[j].muscalar();
-                            }
-                        }
-                    }
-                    if ( spc.p[N].id==id1 || spc.p[N].id==id2 )
-                        d.hist(0) += spc.p[N].mu().dot(spc.p[N].mu()) * spc.p[N].muscalar() * spc.p[N].muscalar();
+                            } );
+                    PairFunctionBase::_sample();
+                }
+
+                public:
+                // self terms
+                void update( data &d ) override
+                {
+                    int id1 = atom[ d.name1 ].id;
+                    int id2 = atom[ d.name2 ].id;
+                    for ( auto &a : spc.p )
+                        if ( a.id==id1 || a.id==id2 )
+                            d.hist(0) += a.mu().dot(a.mu()) * a.muscalar() * a.muscalar();
                 }
 
                 void normalize(data &d) override
                 {
                     double sum = 0;  
-                    for (auto &i : d.hist.getMap()) {
-                        sum += i.second;
-                        i.second = sum;
-                    }
+                    d.hist.forEach( [&](double, double &y) {
+                        sum += y;
+                        y = sum;
+                    } );
                 }
 
                 KirkwoodFactor( Tmjson j, Tspace &spc ) : PairFunctionBase(j,"KirkwoodFactor"), spc(spc) {
+                    for (auto &d : datavec)
+                        sampler.add( atom[ d.name1 ].id, atom[ d.name2 ].id, d.dr, d.rmax );
                     mucorr_angle.setResolution(datavec.back().dr*0.1); // Interval goes only from -1 to 1, thus we generally must increase the resolution, hence the factor of 0.1
                     mucorr_dist.setResolution(datavec.back().dr);
                 }
@@ -2516,8 +2856,8 @@ namespace Faunus
             class Capanalysis : public PairFunctionBase {
                 Tspace &spc;
 
-                Table2D<double, double> capcorr_angle;
-                Table2D<double, Average<double> > capcorr, capcorr_dist;
+                BinnedTable<double, double> capcorr_angle;
+                BinnedTable<double, Average<double> > capcorr, capcorr_dist;
 
                 void update( data &d ) override
                 {
@@ -2548,10 +2888,10 @@ namespace Faunus
                 void normalize(data &d) override
                 {
                     double sum = 0;  
-                    for (auto &i : d.hist.getMap()) {
-                        sum += i.second;
-                        i.second = sum;
-                    }
+                    d.hist.forEach( [&](double, double &y) {
+                        sum += y;
+                        y = sum;
+                    } );
                 }
 
                 public:
@@ -2589,6 +2929,10 @@ namespace Faunus
          * `qmin`    | Minimum q value (1/angstrom)
          * `qmax`    | Maximum q value (1/angstrom)
          * `dq`      | q spacing (1/angstrom)
+         * `histogram` | Bin pair distances before transforming to I(q) (bool, default: false)
+         * `rbin`    | Distance resolution in histogram mode (default: 0.01 angstrom)
+         *
+         * See `Scatter::DebyeFormula` for details.
          */
         template<class Tspace, class Tformfactor=Scatter::FormFactorUnity<double>>
             class ScatteringFunction : public AnalysisBase {
@@ -2681,19 +3025,54 @@ namespace Faunus
          * `aamfile`               |  Save AAM file at end of simulation, i.e. `"aamfile" : {"file":"conf.aam"}`
          * `statefile`             |  Save state file at end of simulation, i.e. `"statefile" : {"file":"state"}`
          * `_jsonfile`             |  Ouput json file w. collected results (default: analysis_out.json)
+         * `_async`                |  Run analyses in the background (default: false)
+         * `_asyncbuffer`          |  Number of buffered snapshots in background mode (default: 4)
+         * `_asyncthreads`         |  OpenMP threads for background analyses (default: 1)
+         *
+         * In background mode, `sample()` copies particles, geometry and groups
+         * into a ring buffer whenever a background analysis is due, and a separate
+         * thread replays the snapshots, in order, into a private `Space` on which
+         * the analyses operate. Different analyses of the same snapshot are
+         * distributed over `_asyncthreads` OpenMP threads. When the buffer is full,
+         * `sample()` waits, so memory is bounded. Each analysis sees exactly the
+         * same configurations as when run inline, so results are deterministic;
+         * `info()`, `json()` and `test()` wait for all pending snapshots.
+         * Only analyses that merely read the configuration are moved to the
+         * background (`atomrdf`, `molrdf`, `scatter`, `kirkwoodfactor`,
+         * `capanalysis`, `multipoleanalysis`, `multipoledistribution`,
+         * `chargemultipole`, `polymershape`, `cyldensity`, `xtcfile`); analyses that
+         * draw random numbers or evaluate the Hamiltonian always run inline.
          */
         class CombinedAnalysis : public AnalysisBase
         {
             private:
                 typedef std::shared_ptr<AnalysisBase> Tptr;
-                vector <Tptr> v;
+                std::shared_ptr<void> shadow;  // space for background analyses (must outlive these)
+                vector <Tptr> v;               // analyses run inline
+                vector <Tptr> w;               // analyses run in the background
                 string _info() override;
                 void _sample() override;
                 string jsonfile;
+
+                // background mode
+                size_t capacity;                       // number of snapshots in ring buffer
+                int nthreads;                          // OpenMP threads for background analyses
+                unsigned long head, tail;              // number of stored and processed snapshots
+                vector<vector<char>> duemask;          // background analyses due for each slot
+                std::function<void(size_t)> capture;   // store current state in slot
+                std::function<void(size_t)> load;      // restore slot into shadow space
+                std::mutex mtx;
+                std::condition_variable notFull, notEmpty, idle;
+                std::thread worker;
+                bool stop;
+                std::exception_ptr error;              // exception thrown in background
+
+                void backgroundLoop();
+                void flush();                          // wait for all snapshots to be processed
             public:
 
                 template<class Tspace, class Tpotential>
-                    CombinedAnalysis( Tmjson &j, Tpotential &pot, Tspace &spc )
+                    CombinedAnalysis( Tmjson &j, Tpotential &pot, Tspace &spc ) : head(0), tail(0), stop(false)
                     {
                         using std::ref;
                         using std::placeholders::_1;
@@ -2702,13 +3081,29 @@ namespace Faunus
 
                         jsonfile = m.value("_jsonfile", "analysis_out.json");
 
+                        // in background mode, read-only analyses operate on a private space
+                        bool async = m.value("_async", false);
+                        capacity = std::max(m.value("_asyncbuffer", 4), 1);
+                        nthreads = std::max(m.value("_asyncthreads", 1), 1);
+                        if ( async )
+                        {
+                            auto s = std::make_shared<Tspace>(spc.geo, spc.molecule);
+                            auto ring = std::make_shared<vector<typename Tspace::Snapshot>>(capacity);
+                            capture = [ring, &spc]( size_t k ) { spc.snapshot((*ring)[k]); };
+                            load = [ring, s]( size_t k ) { s->restore((*ring)[k]); };
+                            duemask.resize(capacity);
+                            shadow = s;
+                        }
+                        Tspace &bspc = async ? *std::static_pointer_cast<Tspace>(shadow) : spc;
+                        auto bg = [&]( AnalysisBase *a ) { (async ? w : v).push_back(Tptr(a)); };
+
                         for ( auto i = m.begin(); i != m.end(); ++i )
                         {
                             auto &val = i.value();
 
                             try {
                                 if ( i.key() == "xtcfile" )
-                                    v.push_back(Tptr(new XTCtraj<Tspace>(val, spc)));
+                                    bg(new XTCtraj<Tspace>(val, bspc));
 
                                 if ( i.key() == "pqrfile" )
                                 {
@@ -2743,10 +3138,10 @@ namespace Faunus
                                     v.push_back(Tptr(new VirtualVolumeMove<Tspace>(val, pot, spc)));
 
                                 if ( i.key() == "polymershape" )
-                                    v.push_back(Tptr(new PolymerShape<Tspace>(val, spc)));
+                                    bg(new PolymerShape<Tspace>(val, bspc));
 
                                 if ( i.key() == "cyldensity" )
-                                    v.push_back(Tptr(new CylindricalDensity<Tspace>(val, spc)));
+                                    bg(new CylindricalDensity<Tspace>(val, bspc));
 
                                 if ( i.key() == "widom" )
                                     v.push_back(Tptr(new Widom<Tspace>(val, pot, spc)));
@@ -2758,31 +3153,31 @@ namespace Faunus
                                     v.push_back(Tptr(new WidomMolecule<Tspace>(val, pot, spc)));
 
                                 if ( i.key() == "chargemultipole" )
-                                    v.push_back(Tptr(new ChargeMultipole<Tspace>(val, spc)));
+                                    bg(new ChargeMultipole<Tspace>(val, bspc));
 
                                 if ( i.key() == "multipoledistribution" )
-                                    v.push_back(Tptr(new MultipoleDistribution<Tspace>(val, spc)));
+                                    bg(new MultipoleDistribution<Tspace>(val, bspc));
 
                                 if ( i.key() == "kirkwoodfactor" )
-                                    v.push_back(Tptr(new KirkwoodFactor<Tspace>(val, spc)));
+                                    bg(new KirkwoodFactor<Tspace>(val, bspc));
 
                                 if ( i.key() == "capanalysis" )
-                                    v.push_back(Tptr(new Capanalysis<Tspace>(val, spc)));
+                                    bg(new Capanalysis<Tspace>(val, bspc));
 
                                 if ( i.key() == "multipoleanalysis" )
-                                    v.push_back(Tptr(new MultipoleAnalysis<Tspace>(val, spc)));
+                                    bg(new MultipoleAnalysis<Tspace>(val, bspc));
 
                                 if ( i.key() == "meanforce" )
                                     v.push_back(Tptr(new MeanForce(val, pot, spc)));
 
                                 if ( i.key() == "atomrdf" )
-                                    v.push_back(Tptr(new AtomRDF<Tspace>(val, spc)));
+                                    bg(new AtomRDF<Tspace>(val, bspc));
 
                                 if ( i.key() == "molrdf" )
-                                    v.push_back(Tptr(new MoleculeRDF<Tspace>(val, spc)));
+                                    bg(new MoleculeRDF<Tspace>(val, bspc));
 
                                 if ( i.key() == "scatter" )
-                                    v.push_back(Tptr(new ScatteringFunction<Tspace>(val, spc)));
+                                    bg(new ScatteringFunction<Tspace>(val, bspc));
                             }
                             catch(std::exception &e)
                             {
@@ -2790,6 +3185,8 @@ namespace Faunus
                                 throw;
                             }
                         }
+                        if ( !w.empty())
+                            worker = std::thread(&CombinedAnalysis::backgroundLoop, this);
                     }
 
                 /**
@@ -2814,12 +3211,13 @@ namespace Faunus
                     {
                         static_assert(std::is_base_of<AnalysisBase, Tanalysis>::value,
                                 "`Tanalysis` must be derived from `Analysis::Analysisbase`");
-                        for ( auto b : v )
-                        {
-                            auto ptr = std::dynamic_pointer_cast<Tanalysis>( b );
-                            if ( ptr != nullptr )
-                                return ptr;
-                        }
+                        for ( auto &l : {v, w} )
+                            for ( auto b : l )
+                            {
+                                auto ptr = std::dynamic_pointer_cast<Tanalysis>( b );
+                                if ( ptr != nullptr )
+                                    return ptr;
+                            }
                         return nullptr;
                     }
 
@@ -25,6 +25,7 @@
 #include <type_traits>
 #include <tuple>
 #include <iterator>
+#include <array>
 
 #endif
 
@@ -154,12 +154,43 @@ namespace Faunus
         virtual double external( const Tpvec & )                // External energy - pressure, for example.
         { return 0; }
 
+        /**
+         * @brief Change in external energy, trial minus current, due to `Change`
+         *
+         * The default evaluates `external()` on both particle vectors.
+         * Derived classes where only moved particles contribute should
+         * override this with an O(k) version for k moved particles.
+         */
+        virtual double externalChange( const typename Tspace::Change & )
+        {
+            assert(spc != nullptr);
+            return external(spc->trial) - external(spc->p);
+        }
+
         virtual double update( bool= true )                     // Bool is acceptance/rejection of previous move
         { return 0; }
 
         /** @brief Update energy function due to Change */
         virtual double updateChange( const typename Tspace::Change &c ) { return 0; }
 
+        /**
+         * @brief Bring lazily built data up to date before concurrent evaluation
+         *
+         * Called on a single thread, after `updateChange()`, before energy
+         * functions are evaluated for `Space::p` and `Space::trial` on several
+         * threads, see `ParallelGroupEnergy`. Terms that build cells,
+         * neighbour lists etc. on demand must do so here.
+         */
+        virtual void prepare() {}
+
+        /**
+         * @brief Discard all data derived from the configuration in `Space::p`
+         *
+         * Call when particles have been replaced outside of the moves, for
+         * example by `Move::ReplicaExchange`. Must be followed by `setSpace()`.
+         */
+        virtual void refresh() {}
+
         virtual void field( const Tpvec &, Eigen::MatrixXd & ) //!< Calculate electric field on all particles
         {}
 
@@ -254,6 +285,11 @@ namespace Faunus
 
         double external( const Tpvec &p ) override { return first.external(p) + second.external(p); }
 
+        double externalChange( const typename Tspace::Change &c ) override
+        {
+            return first.externalChange(c) + second.externalChange(c);
+        }
+
         double update( bool b ) override { return first.update(b) + second.update(b); }
 
         double updateChange( const typename Tspace::Change &c ) override
@@ -261,6 +297,18 @@ namespace Faunus
             return first.updateChange(c) + second.updateChange(c);
         }
 
+        void prepare() override
+        {
+            first.prepare();
+            second.prepare();
+        }
+
+        void refresh() override
+        {
+            first.refresh();
+            second.refresh();
+        }
+
         double v2v( const Tpvec &p1, const Tpvec &p2 ) override { return first.v2v(p1, p2) + second.v2v(p1, p2); }
 
         void field( const Tpvec &p, Eigen::MatrixXd &E ) override
@@ -1027,42 +1075,903 @@ namespace Faunus
         }
     };
 
+/**
+     * @brief Nonbonded energy using cell lists for short ranged pair potentials
+     *
+     * Particles in `Space::p` are kept in a linked-cell list
+     * (`Geometry::CellList`) so that interactions with a single particle only
+     * visit neighbouring cells. The list follows accepted moves through
+     * `updateChange()` and `update()`: particles reported in `Space::Change`
+     * are skipped in the cell search of the trial vector and instead handled
+     * explicitly, and re-assigned to cells upon acceptance. Volume moves,
+     * particle insertion/deletion as well as accepted moves that do not
+     * report a change trigger a full rebuild.
+     *
+     * The pair potential must vanish beyond the cutoff (use for example `CutShift`
+     * or `CoulombGalore`) and only cuboidal geometries are supported.
+     * The following keyword is read from section `energy/nonbonded`:
+     *
+     * Keyword      |  Description
+     * :----------- |  :------------------------------------
+     * `cutoff`     |  Pair potential cutoff (angstrom)
+     */
+    template<class Tspace, class Tpairpot>
+    class NonbondedCellList : public Nonbonded<Tspace, Tpairpot>
+    {
+    protected:
+        typedef Nonbonded<Tspace, Tpairpot> base;
+        typedef typename base::Tparticle Tparticle;
+        typedef typename base::Tpvec Tpvec;
+        using base::spc;
+        using base::geo;
+        using base::pairpot;
+
+        Geometry::CellList cells;      // cells for accepted particle vector, `Space::p`
+        Geometry::CellList trialcells; // transient cells for trial vector with many moved particles
+        bool stale;                    // true if `cells` must be rebuilt before use
+        bool trialstale;               // true if `trialcells` must be rebuilt before use
+        bool rebuildOnUpdate;          // true if current change requires full rebuild
+        double rc2;                    // squared cutoff
+        std::vector<char> moved;       // particles touched by current trial move
+        std::vector<int> movedlist;    // index of particles touched by current trial move
+        unsigned long int cntRebuild;  // number of full cell list rebuilds
+        double avgNeighbours;          // average number of particles in a neighbour search
+
+        /** @brief Matches all particle indices */
+        struct Everything
+        {
+            inline bool find( int ) const { return true; }
+        };
+
+        string _info() override
+        {
+            using namespace textio;
+            std::ostringstream o;
+            auto n = cells.gridSize();
+            o << base::_info()
+              << pad(SUB, 25, "Cell list cutoff") << cells.cutoff() << _angstrom << endl
+              << pad(SUB, 25, "Cell grid") << n[0] << "x" << n[1] << "x" << n[2] << endl
+              << pad(SUB, 25, "Average neighbours") << avgNeighbours << endl
+              << pad(SUB, 25, "Number of rebuilds") << cntRebuild << endl;
+            return o.str();
+        }
+
+        inline double pairEnergy( const Tparticle &a, const Tparticle &b )
+        {
+            double r2 = geo.sqdist(a, b);
+            return (r2 < rc2) ? pairpot(a, b, r2) : 0;
+        }
+
+        /** @brief Ensure that cells match `Space::p` */
+        void sync()
+        {
+            if ( stale || cells.size() != spc->p.size())
+            {
+                cells.setGeometry(geo, std::sqrt(rc2));
+                cells.build(spc->p);
+                avgNeighbours = cells.averageNeighbours();
+                cntRebuild++;
+                stale = false;
+            }
+        }
+
+        /**
+         * @brief Find cell list matching given particle vector
+         *
+         * Returns `true` if moved particles in the trial vector are
+         * excluded from the cell list and must be handled explicitly.
+         * If most particles have moved, transient cells are generated
+         * for the trial vector.
+         */
+        bool cellsFor( const Tpvec &p, const Geometry::CellList *&c )
+        {
+            if ( base::isTrial(p) && !movedlist.empty())
+            {
+                if ( 8 * movedlist.size() < p.size())
+                {
+                    sync();
+                    c = &cells;
+                    return true;
+                }
+                if ( trialstale || trialcells.size() != p.size())
+                {
+                    trialcells.setGeometry(geo, std::sqrt(rc2));
+                    trialcells.build(p);
+                    trialstale = false;
+                }
+                c = &trialcells;
+                return false;
+            }
+            sync();
+            c = &cells;
+            return false;
+        }
+
+        /** @brief Energy of particle `a` with indices in `g` using cells; `i` is excluded */
+        template<class Tgroup>
+        double neighbourEnergy( const Tpvec &p, const Tparticle &a, int i, const Tgroup &g )
+        {
+            const Geometry::CellList *c;
+            double u = 0;
+            if ( cellsFor(p, c))
+            {
+                c->forNeighbours(a, [&]( int j ) {
+                    if ( j != i && !moved[j] && g.find(j))
+                        u += pairEnergy(a, p[j]);
+                });
+                for ( auto j : movedlist )
+                    if ( j != i && g.find(j))
+                        u += pairEnergy(a, p[j]);
+            }
+            else
+                c->forNeighbours(a, [&]( int j ) {
+                    if ( j != i && g.find(j))
+                        u += pairEnergy(a, p[j]);
+                });
+            return u;
+        }
+
+        /** @brief Decide if cell search is cheaper than looping over `n` particles */
+        bool useCells( int n ) const { return n > 2 * avgNeighbours; }
+
+    public:
+        NonbondedCellList( Tmjson &j, const string &sec = "nonbonded" ) : base(j, sec),
+            stale(true), trialstale(true), rebuildOnUpdate(false), cntRebuild(0), avgNeighbours(0)
+        {
+            rc2 = std::pow(j["energy"][sec].at("cutoff").get<double>(), 2);
+            base::name += " (cell list)";
+        }
+
+        auto tuple() -> decltype(std::make_tuple(this))
+        {
+            return std::make_tuple(this);
+        }
+
+        void setSpace( Tspace &s ) override
+        {
+            bool newbox = (spc != &s) || (geo.len != s.geo.len);
+            base::setSpace(s);
+            if ( newbox )
+                stale = trialstale = true;
+        }
+
+        double updateChange( const typename Tspace::Change &c ) override
+        {
+            moved.resize(spc->p.size(), false);
+            rebuildOnUpdate = c.empty() || c.geometryChange || !c.rmGroup.empty() || !c.inGroup.empty();
+            if ( !rebuildOnUpdate )
+                for ( auto &m : c.mvGroup )
+                {
+                    auto g = spc->groupList().at(m.first);
+                    if ( m.second.empty())
+                        movedlist.insert(movedlist.end(), g->begin(), g->end());
+                    else
+                        movedlist.insert(movedlist.end(), m.second.begin(), m.second.end());
+                }
+            for ( auto i : movedlist )
+                moved.at(i) = true;
+            trialstale = true;
+            return base::updateChange(c);
+        }
+
+        double update( bool acceptance ) override
+        {
+            if ( acceptance )
+            {
+                if ( rebuildOnUpdate )
+                    stale = true;
+                else if ( !stale && cells.size() == spc->p.size())
+                    for ( auto i : movedlist )
+                        cells.update(i, spc->p[i]);
+            }
+            for ( auto i : movedlist )
+                moved[i] = false;
+            movedlist.clear();
+            rebuildOnUpdate = false;
+            trialstale = true;
+            return base::update(acceptance);
+        }
+
+        /** @brief Force full rebuild of cells before next energy evaluation */
+        void rebuild() { stale = trialstale = true; }
+
+        /** @brief Number of full cell list rebuilds */
+        unsigned long int numRebuilds() const { return cntRebuild; }
+
+        /** @brief Build cells for `Space::p` and, if used, transient cells for `Space::trial` */
+        void prepare() override
+        {
+            const Geometry::CellList *c;
+            cellsFor(spc->trial, c);
+            sync();
+            base::prepare();
+        }
+
+        void refresh() override
+        {
+            rebuild();
+            base::refresh();
+        }
+
+        double all2p( const Tpvec &p, const Tparticle &a ) override
+        {
+            if ( &p != &spc->p && !base::isTrial(p))
+                return base::all2p(p, a);
+            return neighbourEnergy(p, a, -1, Everything());
+        }
+
+        double i2i( const Tpvec &p, int i, int j ) override
+        {
+            return pairEnergy(p[i], p[j]);
+        }
+
+        double i2g( const Tpvec &p, Group &g, int i ) override
+        {
+            if ( !useCells(g.size()))
+            {
+                double u = 0;
+                for ( auto j : g )
+                    if ( j != i )
+                        u += pairEnergy(p[i], p[j]);
+                return u;
+            }
+            return neighbourEnergy(p, p[i], i, g);
+        }
+
+        double i2all( Tpvec &p, int i ) override
+        {
+            assert(i >= 0 && i < int(p.size()) && "index i outside particle vector");
+            return neighbourEnergy(p, p[i], i, Everything());
+        }
+
+        double g2g( const Tpvec &p, Group &g1, Group &g2 ) override
+        {
+            if ( g1.empty() || g2.empty())
+                return 0;
+            if ( g1.find(g2.front()) || g2.find(g1.front()))
+                return base::g2g(p, g1, g2); // one group is a subgroup of the other
+            Group &small = (g1.size() < g2.size()) ? g1 : g2;
+            Group &large = (g1.size() < g2.size()) ? g2 : g1;
+            double u = 0;
+            if ( useCells(large.size()))
+                for ( auto i : small )
+                    u += neighbourEnergy(p, p[i], i, large);
+            else
+                for ( auto i : small )
+                    for ( auto j : large )
+                        u += pairEnergy(p[i], p[j]);
+            return u;
+        }
+
+        double g_internal( const Tpvec &p, Group &g ) override
+        {
+            if ( !useCells(g.size()))
+                return base::g_internal(p, g);
+            double u = 0;
+            const Geometry::CellList *c;
+            if ( cellsFor(p, c))
+            {
+                for ( auto i : g )
+                    if ( !moved[i] )
+                        c->forNeighbours(p[i], [&]( int j ) {
+                            if ( j > i && !moved[j] && g.find(j))
+                                u += pairEnergy(p[i], p[j]);
+                        });
+                for ( auto i : movedlist )
+                    if ( g.find(i))
+                        for ( auto j : g )
+                            if ( j != i && (!moved[j] || j > i))
+                                u += pairEnergy(p[i], p[j]);
+            }
+            else
+                for ( auto i : g )
+                    c->forNeighbours(p[i], [&]( int j ) {
+                        if ( j > i && g.find(j))
+                            u += pairEnergy(p[i], p[j]);
+                    });
+            return u + pairpot.internal(p, g);
+        }
+    };
+
+    /**
+     * @brief Nonbonded energy using Verlet neighbour lists with a skin
+     *
+     * For each particle in `Space::p` the indices of all particles closer than
+     * `cutoff+skin` are stored in a compact (CSR) neighbour list, built in
+     * O(N) using `Geometry::CellList` for cuboidal geometries and in O(N^2)
+     * otherwise. Displacements of particles reported in `Space::Change` are
+     * accumulated upon acceptance and the list is rebuilt lazily only when
+     * the largest displacement since the last build exceeds half the skin.
+     * A trial configuration is evaluated with the list if the reported trial
+     * displacements are also within the skin; otherwise, and for volume
+     * moves, insertions and unreported changes, the energy is calculated
+     * by the N-squared base class, `Tnonbonded`, which may be either
+     * `Nonbonded` or `NonbondedVector`.
+     *
+     * The pair potential must vanish beyond the cutoff.
+     * The following keywords are read from section `energy/nonbonded`:
+     *
+     * Keyword      |  Description
+     * :----------- |  :------------------------------------
+     * `cutoff`     |  Pair potential cutoff (angstrom)
+     * `skin`       |  Verlet skin thickness (angstrom, default: 2)
+     */
+    template<class Tspace, class Tpairpot, class Tnonbonded=Nonbonded<Tspace, Tpairpot> >
+    class NonbondedVerlet : public Tnonbonded
+    {
+    protected:
+        typedef Tnonbonded base;
+        typedef typename base::Tparticle Tparticle;
+        typedef typename base::Tpvec Tpvec;
+        using base::spc;
+        using base::geo;
+        using base::pairpot;
+
+        double rc;                     // pair potential cutoff
+        double skin;                   // Verlet skin thickness
+        double dmax;                   // largest accepted displacement since last build
+        bool stale;                    // true if list must be rebuilt before use
+        bool trialOK;                  // true if list is valid for trial vector
+        bool rebuildOnUpdate;          // true if current change requires full rebuild
+        std::vector<int> first;        // neighbours of i are in `nb[first[i]:first[i+1]]`
+        std::vector<int> nb;           // neighbour indices of all particles
+        std::vector<Point> ref;        // positions at last build
+        std::vector<int> movedlist;    // index of particles touched by current trial move
+        Geometry::CellList cells;      // used to build the list in O(N)
+        unsigned long int cntRebuild;  // number of list rebuilds
+
+        string _info() override
+        {
+            using namespace textio;
+            std::ostringstream o;
+            o << base::_info()
+              << pad(SUB, 25, "Verlet cutoff+skin") << rc << "+" << skin << _angstrom << endl
+              << pad(SUB, 25, "Neighbour list size") << nb.size() << endl
+              << pad(SUB, 25, "Average neighbours") << averageNeighbours() << endl
+              << pad(SUB, 25, "Number of rebuilds") << cntRebuild << endl;
+            return o.str();
+        }
+
+        inline double pairEnergy( const Tparticle &a, const Tparticle &b )
+        {
+            return base::p2p(a, b);
+        }
+
+        /** @brief Neighbour search for cuboids using cells */
+        template<class Tvec>
+        void build( const Tvec &p, std::true_type )
+        {
+            double rl2 = (rc + skin) * (rc + skin);
+            cells.setGeometry(geo, rc + skin);
+            cells.build(p);
+            for ( int i = 0; i < (int) p.size(); i++ )
+            {
+                first[i] = nb.size();
+                cells.forNeighbours(p[i], [&]( int j ) {
+                    if ( j != i && geo.sqdist(p[i], p[j]) < rl2 )
+                        nb.push_back(j);
+                });
+            }
+        }
+
+        /** @brief Neighbour search for any other geometry */
+        template<class Tvec>
+        void build( const Tvec &p, std::false_type )
+        {
+            double rl2 = (rc + skin) * (rc + skin);
+            for ( int i = 0; i < (int) p.size(); i++ )
+            {
+                first[i] = nb.size();
+                for ( int j = 0; j < (int) p.size(); j++ )
+                    if ( j != i && geo.sqdist(p[i], p[j]) < rl2 )
+                        nb.push_back(j);
+            }
+        }
+
+        /** @brief Ensure that neighbour list matches `Space::p` */
+        void sync()
+        {
+            if ( stale || ref.size() != spc->p.size() || 2 * dmax > skin )
+            {
+                const Tpvec &p = spc->p;
+                nb.clear();
+                first.resize(p.size() + 1);
+                build(p, std::is_base_of<Geometry::Cuboid, typename Tspace::GeometryType>());
+                first[p.size()] = nb.size();
+                ref.resize(p.size());
+                for ( size_t i = 0; i < p.size(); i++ )
+                    ref[i] = p[i];
+                dmax = 0;
+                stale = false;
+                cntRebuild++;
+            }
+        }
+
+        /** @brief Largest displacement of moved particles in trial vector */
+        double trialDisplacement() const
+        {
+            double d2 = 0;
+            for ( auto i : movedlist )
+                d2 = std::max(d2, geo.sqdist(spc->trial[i], ref[i]));
+            return std::sqrt(d2);
+        }
+
+        /**
+         * @brief Check if trial displacement `d` keeps all pairs within the skin
+         *
+         * A pair may be missing from the list only if the sum of the
+         * displacements of both particles exceeds the skin.
+         */
+        bool withinSkin( double d ) const
+        {
+            return (d + dmax <= skin) && (movedlist.size() < 2 || 2 * d <= skin);
+        }
+
+        /** @brief Determines if the neighbour list can be used for the given vector */
+        bool useList( const Tpvec &p )
+        {
+            if ( &p == &spc->p )
+            {
+                sync();
+                return true;
+            }
+            return trialOK && base::isTrial(p);
+        }
+
+        /** @brief Decide if list is cheaper than looping over `n` particles */
+        bool useList( const Tpvec &p, int n )
+        {
+            return n > 2 * averageNeighbours() && useList(p);
+        }
+
+    public:
+        NonbondedVerlet( Tmjson &j ) : base(j), dmax(0), stale(true), trialOK(false),
+                                       rebuildOnUpdate(false), cntRebuild(0)
+        {
+            auto &_j = j["energy"]["nonbonded"];
+            rc = _j.at("cutoff").get<double>();
+            skin = _j.value("skin", 2.0);
+            if ( skin < 0 )
+                throw std::runtime_error("Verlet skin must be positive");
+            base::name += " (Verlet list)";
+        }
+
+        auto tuple() -> decltype(std::make_tuple(this))
+        {
+            return std::make_tuple(this);
+        }
+
+        void setSpace( Tspace &s ) override
+        {
+            bool newbox = (spc != &s) || (geo.getVolume() != s.geo.getVolume());
+            base::setSpace(s);
+            if ( newbox )
+                stale = true;
+        }
+
+        double updateChange( const typename Tspace::Change &c ) override
+        {
+            trialOK = false;
+            rebuildOnUpdate = c.empty() || c.geometryChange || !c.rmGroup.empty() || !c.inGroup.empty();
+            if ( !rebuildOnUpdate )
+            {
+                for ( auto &m : c.mvGroup )
+                {
+                    auto g = spc->groupList().at(m.first);
+                    if ( m.second.empty())
+                        movedlist.insert(movedlist.end(), g->begin(), g->end());
+                    else
+                        movedlist.insert(movedlist.end(), m.second.begin(), m.second.end());
+                }
+                sync();
+                double d = trialDisplacement();
+                if ( !withinSkin(d) && dmax > 0 )
+                {
+                    stale = true; // rebuilding may bring trial vector within the skin
+                    sync();
+                    d = trialDisplacement();
+                }
+                trialOK = withinSkin(d);
+            }
+            return base::updateChange(c);
+        }
+
+        double update( bool acceptance ) override
+        {
+            if ( acceptance )
+            {
+                if ( rebuildOnUpdate )
+                    stale = true;
+                else if ( ref.size() == spc->p.size())
+                    for ( auto i : movedlist )
+                        dmax = std::max(dmax, std::sqrt(geo.sqdist(spc->p[i], ref[i])));
+            }
+            movedlist.clear();
+            rebuildOnUpdate = trialOK = false;
+            return base::update(acceptance);
+        }
+
+        /** @brief Force rebuild of neighbour list before next energy evaluation */
+        void rebuild() { stale = true; }
+
+        void prepare() override
+        {
+            sync();
+            base::prepare();
+        }
+
+        void refresh() override
+        {
+            rebuild();
+            base::refresh();
+        }
+
+        /** @brief Number of neighbour list rebuilds */
+        unsigned long int numRebuilds() const { return cntRebuild; }
+
+        /** @brief Average number of neighbours per particle */
+        double averageNeighbours() const
+        {
+            return ref.empty() ? 0 : double(nb.size()) / ref.size();
+        }
+
+        /** @brief Neighbour list statistics as json object */
+        Tmjson json() const
+        {
+            Tmjson j;
+            j[base::name] = {
+                {"cutoff", rc},
+                {"skin", skin},
+                {"rebuilds", cntRebuild},
+                {"list size", nb.size()},
+                {"average neighbours", averageNeighbours()}
+            };
+            return j;
+        }
+
+        double i2g( const Tpvec &p, Group &g, int i ) override
+        {
+            if ( !useList(p, g.size()))
+                return base::i2g(p, g, i);
+            double u = 0;
+            for ( int k = first[i]; k < first[i + 1]; k++ )
+                if ( g.find(nb[k]))
+                    u += pairEnergy(p[i], p[nb[k]]);
+            return u;
+        }
+
+        double i2all( Tpvec &p, int i ) override
+        {
+            assert(i >= 0 && i < int(p.size()) && "index i outside particle vector");
+            if ( !useList(p))
+                return base::i2all(p, i);
+            double u = 0;
+            for ( int k = first[i]; k < first[i + 1]; k++ )
+                u += pairEnergy(p[i], p[nb[k]]);
+            return u;
+        }
+
+        double g2g( const Tpvec &p, Group &g1, Group &g2 ) override
+        {
+            if ( g1.empty() || g2.empty())
+                return 0;
+            if ( g1.find(g2.front()) || g2.find(g1.front()))
+                return base::g2g(p, g1, g2); // one group is a subgroup of the other
+            Group &small = (g1.size() < g2.size()) ? g1 : g2;
+            Group &large = (g1.size() < g2.size()) ? g2 : g1;
+            if ( !useList(p, large.size()))
+                return base::g2g(p, g1, g2);
+            double u = 0;
+            for ( auto i : small )
+                for ( int k = first[i]; k < first[i + 1]; k++ )
+                    if ( large.find(nb[k]))
+                        u += pairEnergy(p[i], p[nb[k]]);
+            return u;
+        }
+
+        double g_internal( const Tpvec &p, Group &g ) override
+        {
+            if ( !useList(p, g.size()))
+                return base::g_internal(p, g);
+            double u = 0;
+            for ( auto i : g )
+                for ( int k = first[i]; k < first[i + 1]; k++ )
+                    if ( nb[k] > i && g.find(nb[k]))
+                        u += pairEnergy(p[i], p[nb[k]]);
+            return u + pairpot.internal(p, g);
+        }
+    };
+
+    /**
+     * @brief Nonbonded energy streaming over structure-of-arrays particle data
+     *
+     * Instead of looping over `Space::p`, where each particle carries all its
+     * properties, pair loops read positions, charges, radii and atom ids from
+     * the contiguous arrays in `Space::soa` and `Space::soa_trial`. These are
+     * enabled upon `setSpace()` and are kept in sync by `Space::syncArrays()`
+     * which is called by `Move::Movebase`. Other particle vectors are handled
+     * by the `Nonbonded` base class.
+     *
+     * Pair potentials implementing `block()` (see `Potential::hasBlock`) are
+     * evaluated for blocks of partners in loops that can be vectorised;
+     * all others are called one pair at a time.
+     * The pair potential may depend on charge, radius and id, only, and
+     * the geometry must be `Cuboid` or derived hereof.
+     */
+    template<class Tspace, class Tpairpot>
+    class NonbondedArrays : public Nonbonded<Tspace, Tpairpot>
+    {
+    protected:
+        typedef Nonbonded<Tspace, Tpairpot> base;
+        typedef typename base::Tparticle Tparticle;
+        typedef typename base::Tpvec Tpvec;
+        typedef typename Tspace::GeometryType Tgeometry;
+        using base::spc;
+        using base::geo;
+        using base::pairpot;
+
+        static_assert(std::is_base_of<Geometry::Cuboid, Tgeometry>::value,
+                      "NonbondedArrays requires a cuboidal geometry");
+        static const bool pbc_xy = !std::is_base_of<Geometry::CuboidNoPBC, Tgeometry>::value;
+        static const bool pbc_z = pbc_xy && !std::is_base_of<Geometry::Cuboidslit, Tgeometry>::value;
+
+        /** @brief Array mirror of given particle vector or `nullptr` if none */
+        const ParticleArrays *arraysFor( const Tpvec &p )
+        {
+            const ParticleArrays *s = nullptr;
+            if ( &p == &spc->p )
+                s = &spc->soa;
+            else if ( base::isTrial(p))
+                s = &spc->soa_trial;
+            else
+                return s;
+            if ( !spc->arraysEnabled())
+                spc->enableArrays();
+            else if ( s->size() != p.size())
+                spc->syncArrays();
+            return s;
+        }
+
+        /** @brief Minimum image of distance component */
+        template<bool pbc>
+        static inline double image( double d, double len, double len_half )
+        {
+            if ( pbc )
+            {
+                d = std::fabs(d);
+                if ( d > len_half )
+                    d -= len;
+            }
+            return d;
+        }
+
+        /** @brief Energy of particle `a` with array elements in range [first,last) */
+        double kernel( const ParticleArrays &s, const Tparticle &a, int first, int last )
+        {
+            return kernel(s, a, first, last, Potential::hasBlock<Tpairpot>());
+        }
+
+        /** @brief Blocked kernel for pair potentials with a vectorised `block()` */
+        double kernel( const ParticleArrays &s, const Tparticle &a, int first, int last, std::true_type )
+        {
+            const int blocksize = 64;
+            double r2[blocksize], u[blocksize];
+            const Point &len = geo.len, &len_half = geo.len_half;
+            double ax = a.x(), ay = a.y(), az = a.z();
+            double sum = 0;
+            for ( int i = first; i < last; i += blocksize )
+            {
+                int n = std::min(blocksize, last - i);
+                const double *x = s.x.data() + i, *y = s.y.data() + i, *z = s.z.data() + i;
+#pragma omp simd
+                for ( int k = 0; k < n; k++ )
+                {
+                    double dx = image<pbc_xy>(x[k] - ax, len.x(), len_half.x());
+                    double dy = image<pbc_xy>(y[k] - ay, len.y(), len_half.y());
+                    double dz = image<pbc_z>(z[k] - az, len.z(), len_half.z());
+                    r2[k] = dx * dx + dy * dy + dz * dz;
+                    u[k] = 0;
+                }
+                pairpot.block(a, {r2, s.charge.data() + i, s.radius.data() + i, s.id.data() + i, n}, u);
+                for ( int k = 0; k < n; k++ )
+                    sum += u[k];
+            }
+            return sum;
+        }
+
+        /** @brief Scalar kernel for any other pair potential */
+        double kernel( const ParticleArrays &s, const Tparticle &a, int first, int last, std::false_type )
+        {
+            const double *x = s.x.data(), *y = s.y.data(), *z = s.z.data();
+            const double *q = s.charge.data(), *r = s.radius.data();
+            const int *id = s.id.data();
+            const Point &len = geo.len, &len_half = geo.len_half;
+            double ax = a.x(), ay = a.y(), az = a.z();
+            Tparticle b = a;
+            double u = 0;
+            for ( int j = first; j < last; j++ )
+            {
+                double dx = image<pbc_xy>(x[j] - ax, len.x(), len_half.x());
+                double dy = image<pbc_xy>(y[j] - ay, len.y(), len_half.y());
+                double dz = image<pbc_z>(z[j] - az, len.z(), len_half.z());
+                b.charge = q[j];
+                b.radius = r[j];
+                b.id = id[j];
+                u += pairpot(a, b, dx * dx + dy * dy + dz * dz);
+            }
+            return u;
+        }
+
+    public:
+        NonbondedArrays( Tmjson &j, const string &sec = "nonbonded" ) : base(j, sec)
+        {
+            base::name += " (SoA)";
+        }
+
+        auto tuple() -> decltype(std::make_tuple(this))
+        {
+            return std::make_tuple(this);
+        }
+
+        void setSpace( Tspace &s ) override
+        {
+            base::setSpace(s);
+            s.enableArrays();
+        }
+
+        void prepare() override
+        {
+            arraysFor(spc->p);
+            arraysFor(spc->trial);
+            base::prepare();
+        }
+
+        double all2p( const Tpvec &p, const Tparticle &a ) override
+        {
+            auto s = arraysFor(p);
+            if ( s == nullptr )
+                return base::all2p(p, a);
+            return kernel(*s, a, 0, p.size());
+        }
+
+        double i2g( const Tpvec &p, Group &g, int i ) override
+        {
+            auto s = arraysFor(p);
+            if ( s == nullptr )
+                return base::i2g(p, g, i);
+            if ( g.empty())
+                return 0;
+            if ( g.find(i))
+                return kernel(*s, p[i], g.front(), i) + kernel(*s, p[i], i + 1, g.back() + 1);
+            return kernel(*s, p[i], g.front(), g.back() + 1);
+        }
+
+        double i2all( Tpvec &p, int i ) override
+        {
+            assert(i >= 0 && i < int(p.size()) && "index i outside particle vector");
+            auto s = arraysFor(p);
+            if ( s == nullptr )
+                return base::i2all(p, i);
+            return kernel(*s, p[i], 0, i) + kernel(*s, p[i], i + 1, p.size());
+        }
+
+        double g2g( const Tpvec &p, Group &g1, Group &g2 ) override
+        {
+            if ( g1.empty() || g2.empty())
+                return 0;
+            auto s = arraysFor(p);
+            if ( s == nullptr || g1.find(g2.front()) || g2.find(g1.front()))
+                return base::g2g(p, g1, g2); // one group is a subgroup of the other
+            double u = 0;
+            for ( auto i : g1 )
+                u += kernel(*s, p[i], g2.front(), g2.back() + 1);
+            return u;
+        }
+
+        double g_internal( const Tpvec &p, Group &g ) override
+        {
+            auto s = arraysFor(p);
+            if ( s == nullptr || g.empty())
+                return base::g_internal(p, g);
+            double u = 0;
+            for ( auto i : g )
+                u += kernel(*s, p[i], i + 1, g.back() + 1);
+            return u + pairpot.internal(p, g);
+        }
+    };
+
 /**
      * @brief Class for handling bond pairs
      *
      * Takes care of bonded interactions and can handle mixed bond types. If you create bond BETWEEN
      * groups, make sure to set the `CrossGroupBonds` to `true`.
      *
+     * Bonds are kept in a compressed sparse row (CSR) table so that the
+     * partners of particle `i` are found in a contiguous range. Potentials
+     * of the types given in the `Tbondpots` tuple (default: `Potential::Harmonic`
+     * and `Potential::FENE`) are stored by value, one vector per type, and
+     * evaluated through compile-time dispatch; any other potential is wrapped
+     * in a `std::function`. Bonds within a molecular group are stored relative to the
+     * first particle of the group so that they follow the group when
+     * `Space::erase()` or `Space::eraseGroup()` shift particle indices. Bonds
+     * of removed groups are dropped and, if no bonds were added before
+     * `setSpace()`, molecular bonds of inserted groups are added.
+     * Adding the same pair twice replaces the first bond.
+     *
      * Example:
      *
      *     vector<particle> p(...);            // particle vector
      *     int i=10, j=11;                     // particle index
-     *     Energy::Bonded b;
+     *     Energy::Bonded<Tspace> b;
      *     b.add(i, j, Potential::Harmonic(0.1,5.0) );
+     *     b.setSpace(spc);
      *     std::cout << b.info();
-     *     double rij2 = ... ;                 // squared distance between i and j
-     *     double u = b(i,j)( p[i], p[j], rij2 ); // i j bond energy in kT
+     *     double u = b.i2i(spc.p, i, j);      // i j bond energy in kT
      *
      * @date Lund, 2011-2012
      */
-    template<class Tspace>
-    class Bonded : public Energybase<Tspace>,
-                   protected pair_list<std::function<
-                       double( const typename Tspace::ParticleType &,
-                               const typename Tspace::ParticleType &, double )> >
+    template<class Tspace, class Tbondpots=std::tuple<Potential::Harmonic, Potential::FENE> >
+    class Bonded;
+
+    template<class Tspace, class... Tbondpots>
+    class Bonded<Tspace, std::tuple<Tbondpots...> > : public Energybase<Tspace>
     {
     private:
         typedef typename Energybase<Tspace>::Tparticle Tparticle;
         typedef typename Energybase<Tspace>::Tpvec Tpvec;
 
-        typedef pair_list <std::function<
-            double( const Tparticle &, const Tparticle &, double )>> Tbase;
+        typedef std::function<
+            double( const Tparticle &, const Tparticle &, double )> Tenergy;
 
         typedef std::function<
             Point( const Tparticle &, const Tparticle &, double, const Point & )> Tforce;
 
+        static_assert(sizeof...(Tbondpots) < 255, "too many bond types");
+
+        enum { GENERIC = sizeof...(Tbondpots) };
+
+        /** @brief Position of `T` in `Ts`; equals `sizeof...(Ts)` if absent */
+        template<class T, class... Ts> struct TypeIndex { enum { value = 0 }; };
+        template<class T, class... Ts> struct TypeIndex<T, T, Ts...> { enum { value = 0 }; };
+        template<class T, class U, class... Ts> struct TypeIndex<T, U, Ts...> {
+            enum { value = 1 + TypeIndex<T, Ts...>::value };
+        };
+
+    public:
+        struct Entry
+        {
+            unsigned char type;   // position in `Tbondpots` or `GENERIC`
+            int n;                // position in vector of potentials of that type
+        };
+
+    private:
+        struct Bond
+        {
+            Group *g;             // owning group or nullptr if `i` and `j` are absolute
+            int i, j;
+            Entry e;
+        };
+
+        struct Neighbour
+        {
+            int j;
+            Entry e;
+        };
+
         using Energybase<Tspace>::spc;
-        std::map<typename Tbase::Tpair, Tforce> force_list;
+
+        std::tuple<vector<Tbondpots>...> pots;
+        vector<Tenergy> generic;
+        vector<Tforce> genericForce;
+
+        vector<Bond> bonds;                       // all bonds in order of addition
+        vector<int> offset;                       // partners of i are neighbours[offset[i]:offset[i+1]]
+        vector<Neighbour> neighbours;
+        vector<std::pair<opair<int>, Entry>> bondlist; // absolute indices as of last rebuild
+        std::map<Group *, std::pair<int, int>> known;  // molId and size of groups seen so far
+        std::map<std::pair<int, int>, Entry> molecular; // potential of each (molId, bond index)
+        unsigned long layout;                     // `Space::layoutCount()` at last rebuild
+        bool dirty, autoAdd;
 
         string _infolist;
 
@@ -1072,30 +1981,238 @@ namespace Faunus
             std::ostringstream o;
             o << pad(SUB, 30, "Look for group-group bonds:")
               << std::boolalpha << CrossGroupBonds << endl
+              << pad(SUB, 30, "Number of bonds:") << bondlist.size() << endl
               << indent(SUBSUB) << std::left
               << setw(7) << "i" << setw(7) << "j" << endl;
             return o.str() + _infolist;
         }
 
-        template<class Tpairpot>
-        struct ForceFunctionObject
+        template<class Tpairpot>
+        struct ForceFunctionObject
+        {
+            Tpairpot pot;
+
+            ForceFunctionObject( const Tpairpot &p ) : pot(p) {}
+
+            Point
+            operator()( const Tparticle &a, const Tparticle &b,
+                        double r2, const Point &r )
+            {
+                return pot.force(a, b, r2, r);
+            }
+        };
+
+        template<size_t I>
+        typename std::enable_if<I == GENERIC, double>::type
+        evalEnergy( const Entry &e, const Tparticle &a, const Tparticle &b, double r2 )
+        {
+            return generic[e.n](a, b, r2);
+        }
+
+        template<size_t I>
+        typename std::enable_if<(I < GENERIC), double>::type
+        evalEnergy( const Entry &e, const Tparticle &a, const Tparticle &b, double r2 )
+        {
+            if ( e.type == I )
+                return std::get<I>(pots)[e.n](a, b, r2);
+            return evalEnergy<I + 1>(e, a, b, r2);
+        }
+
+        template<size_t I>
+        typename std::enable_if<I == GENERIC, Point>::type
+        evalForce( const Entry &e, const Tparticle &a, const Tparticle &b, double r2, const Point &r )
+        {
+            return genericForce[e.n](a, b, r2, r);
+        }
+
+        template<size_t I>
+        typename std::enable_if<(I < GENERIC), Point>::type
+        evalForce( const Entry &e, const Tparticle &a, const Tparticle &b, double r2, const Point &r )
+        {
+            if ( e.type == I )
+                return std::get<I>(pots)[e.n].force(a, b, r2, r);
+            return evalForce<I + 1>(e, a, b, r2, r);
+        }
+
+        inline double energy( const Tpvec &p, int i, const Neighbour &nb )
+        {
+            return evalEnergy<0>(nb.e, p[i], p[nb.j], spc->geo.sqdist(p[i], p[nb.j]));
+        }
+
+        /** @brief Store potential of a type in `Tbondpots` */
+        template<class Tpairpot>
+        typename std::enable_if<(int) TypeIndex<Tpairpot, Tbondpots...>::value < (int) GENERIC, Entry>::type
+        store( const Tpairpot &pot )
+        {
+            enum { I = TypeIndex<Tpairpot, Tbondpots...>::value };
+            auto &v = std::get<I>(pots);
+            v.push_back(pot);
+            return Entry{(unsigned char) I, int(v.size()) - 1};
+        }
+
+        /** @brief Store any other potential as `std::function` */
+        template<class Tpairpot>
+        typename std::enable_if<(int) TypeIndex<Tpairpot, Tbondpots...>::value == (int) GENERIC, Entry>::type
+        store( const Tpairpot &pot )
+        {
+            generic.push_back(pot);
+            genericForce.push_back(ForceFunctionObject<Tpairpot>(pot));
+            return Entry{(unsigned char) GENERIC, int(generic.size()) - 1};
+        }
+
+        /**
+         * @brief Add molecular bonds of group `g`
+         *
+         * Potentials are stored once per molecule type and bond so that
+         * repeated insertions, as in grand canonical simulations, reuse them.
+         * Bonds are listed in `info()` only if `info` is true.
+         */
+        void addMolecularBonds( Group *g, bool info = false )
+        {
+            if ( g->molId >= spc->molecule.size())
+                return;
+            auto &list = spc->molecule[g->molId].getBondList();
+            for ( size_t k = 0; k < list.size(); k++ )
+            {
+                auto b = list[k];
+                if ( b.type != Faunus::Bonded::BondData::Type::HARMONIC )
+                    continue;
+                b.shift(g->front());
+                if ( info )
+                    _infolist += infoLine(b.index.at(0), b.index.at(1), Potential::Harmonic(b.k, b.req));
+                auto key = std::make_pair(int(g->molId), int(k));
+                auto it = molecular.find(key);
+                if ( it == molecular.end())
+                {
+                    Potential::Harmonic pot(b.k, b.req);
+                    pot.name.clear();
+                    it = molecular.insert({key, store(pot)}).first;
+                }
+                bonds.push_back(Bond{nullptr, b.index.at(0), b.index.at(1), it->second});
+            }
+            dirty = true;
+        }
+
+        template<class Tpairpot>
+        static string infoLine( int i, int j, Tpairpot pot )
+        {
+            std::ostringstream o;
+            o << textio::indent(textio::SUBSUB) << std::left << setw(7) << i
+              << setw(7) << j << pot.brief() + "\n";
+            return o.str();
+        }
+
+        /**
+         * @brief Rebuild CSR table if bonds were added or particle indices may have shifted
+         *
+         * Bonds of groups no longer in `Space` are dropped, molecular bonds of
+         * new groups are added (if enabled), and bonds given with absolute
+         * indices are attached to their group if both particles are in the same one.
+         */
+        void rebuild()
         {
-            Tpairpot pot;
+            assert(spc != nullptr);
+            if ( !dirty && layout == spc->layoutCount())
+                return;
 
-            ForceFunctionObject( const Tpairpot &p ) : pot(p) {}
+            auto &groups = spc->groupList();
+            std::map<Group *, std::pair<int, int>> present;
+            vector<Group *> added;
+            for ( auto g : groups )
+            {
+                auto id = std::make_pair(int(g->molId), g->size());
+                auto it = known.find(g);
+                if ( it == known.end() || it->second != id )
+                    added.push_back(g);
+                present[g] = id;
+            }
 
-            Point
-            operator()( const Tparticle &a, const Tparticle &b,
-                        double r2, const Point &r )
+            // pointers of removed groups may have been reused for new ones
+            std::set<Group *> fresh(added.begin(), added.end());
+            bonds.erase(std::remove_if(bonds.begin(), bonds.end(), [&]( const Bond &b ) {
+                return b.g != nullptr && (present.count(b.g) == 0 || fresh.count(b.g) > 0);
+            }), bonds.end());
+            known.swap(present);
+
+            if ( autoAdd )
+                for ( auto g : added )
+                    addMolecularBonds(g);
+
+            for ( auto &b : bonds )
+                if ( b.g == nullptr )
+                {
+                    Group *g = spc->findGroup(b.i);
+                    if ( g != nullptr && !g->isAtomic() && g->find(b.j))
+                    {
+                        b.i -= g->front();
+                        b.j -= g->front();
+                        b.g = g;
+                    }
+                }
+
+            // count partners, then fill rows
+            int n = spc->p.size();
+            offset.assign(n + 1, 0);
+            bondlist.clear();
+            auto absolute = [&]( const Bond &b, int &i, int &j ) {
+                i = b.i;
+                j = b.j;
+                if ( b.g != nullptr )
+                {
+                    i += b.g->front();
+                    j += b.g->front();
+                    if ( i > b.g->back() || j > b.g->back())
+                        return false;
+                }
+                return i >= 0 && j >= 0 && i < n && j < n;
+            };
+            int i, j;
+            for ( auto &b : bonds )
+                if ( absolute(b, i, j))
+                {
+                    offset[i + 1]++;
+                    offset[j + 1]++;
+                }
+            for ( int k = 0; k < n; k++ )
+                offset[k + 1] += offset[k];
+            neighbours.resize(offset[n]);
+            vector<int> fill(offset.begin(), offset.end() - 1);
+            for ( auto &b : bonds )
+                if ( absolute(b, i, j))
+                {
+                    neighbours[fill[i]++] = Neighbour{j, b.e};
+                    neighbours[fill[j]++] = Neighbour{i, b.e};
+                }
+
+            // remove duplicate pairs, keeping the last added bond
+            int m = 0;
+            for ( int k = 0; k < n; k++ )
             {
-                return pot.force(a, b, r2, r);
+                int beg = m;
+                for ( int l = offset[k]; l < offset[k + 1]; l++ )
+                {
+                    int q = beg;
+                    while ( q < m && neighbours[q].j != neighbours[l].j )
+                        q++;
+                    neighbours[q] = neighbours[l];
+                    if ( q == m )
+                        m++;
+                }
+                offset[k] = beg;
+                for ( int q = beg; q < m; q++ )
+                    if ( neighbours[q].j > k )
+                        bondlist.push_back({opair<int>(k, neighbours[q].j), neighbours[q].e});
             }
-        };
+            offset[n] = m;
+            neighbours.resize(m);
+            layout = spc->layoutCount();
+            dirty = false;
+        }
 
     public:
         bool CrossGroupBonds; //!< Set to true if bonds cross groups (slower!). Default: false
 
-        Bonded()
+        Bonded() : layout(0), dirty(true), autoAdd(false)
         {
             this->name = "Bonded particles";
             CrossGroupBonds = false;
@@ -1103,32 +2220,34 @@ namespace Faunus
 
         ~Bonded()
         {
-            if ( !Tbase::list.empty())
-                IO::writeFile("bondlist.tcl", VMDBonds(Tbase::list));
+            if ( !bondlist.empty())
+                IO::writeFile("bondlist.tcl", VMDBonds(bondlist));
         }
 
         void setSpace( Tspace &s ) override
         {
             Energybase<Tspace>::setSpace(s);
-            if ( Tbase::mlist.empty())
-                add(spc->groupList()); // search for bonds
+            if ( bonds.empty())
+                autoAdd = true; // search for bonds in current and future groups
+            dirty = true;
+            rebuild();
         }
 
+        void prepare() override { rebuild(); }
+
         auto tuple() -> decltype(std::make_tuple(this))
         {
             return std::make_tuple(this);
         }
 
-        /**
-             * @brief Bond energy i with j
-             * @todo Optimize by using iterator directly as returned by find.
-             */
+        /** @brief Bond energy i with j */
         double i2i( const Tpvec &p, int i, int j ) override
         {
             assert(i != j);
-            auto f = this->list.find(opair<int>(i, j));
-            if ( f != this->list.end())
-                return f->second(p[i], p[j], spc->geo.sqdist(p[i], p[j]));
+            rebuild();
+            for ( int k = offset[i]; k < offset[i + 1]; k++ )
+                if ( neighbours[k].j == j )
+                    return energy(p, i, neighbours[k]);
             return 0;
         }
 
@@ -1142,12 +2261,13 @@ namespace Faunus
             int j = spc->findIndex(b);
             assert(i >= 0 && j >= 0);
             assert(i < (int) spc->p.size() && j < (int) spc->p.size());
-            auto f = force_list.find(opair<int>(i, j));
-            if ( f != this->force_list.end())
-            {
-                auto r = spc->geo.vdist(a, b);
-                return f->second(a, b, r.squaredNorm(), r);
-            }
+            rebuild();
+            for ( int k = offset[i]; k < offset[i + 1]; k++ )
+                if ( neighbours[k].j == j )
+                {
+                    auto r = spc->geo.vdist(a, b);
+                    return evalForce<0>(neighbours[k].e, a, b, r.squaredNorm(), r);
+                }
             return Point(0, 0, 0);
         }
 
@@ -1155,54 +2275,39 @@ namespace Faunus
         double i2all( Tpvec &p, int i ) override
         {
             assert(i >= 0 && i < (int) p.size()); //debug
+            rebuild();
             double u = 0;
-            auto eqr = this->mlist.equal_range(i);
-            for ( auto it = eqr.first; it != eqr.second; ++it )
-            {
-                int j = it->second; // partner index
-                u += this->list[opair<int>(i, j)](
-                    p[i], p[j], spc->geo.sqdist(p[i], p[j]));
-            }
+            for ( int k = offset[i]; k < offset[i + 1]; k++ )
+                u += energy(p, i, neighbours[k]);
             return u;
         }
 
         double total( const Tpvec &p )
         {
+            rebuild();
             double u = 0;
-            for ( auto &m : Tbase::list )
-            {
-                int i = m.first.first;
-                int j = m.first.second;
-                assert(i >= 0 && i < (int) p.size() && j >= 0 && j < (int) p.size()); //debug
-                u += m.second(p[i], p[j], spc->geo.sqdist(p[i], p[j]));
-            }
+            for ( int i = 0; i < (int) offset.size() - 1; i++ )
+                for ( int k = offset[i]; k < offset[i + 1]; k++ )
+                    if ( neighbours[k].j > i )
+                        u += energy(p, i, neighbours[k]);
             return u;
         }
 
         /**
              * Group-to-group bonds are disabled by default as these are
-             * rarely used and the current implementation is rather slow
-             * for systems with *many* groups (but very general). To
-             * activate `g2g()`, set `CrossGroupBonds=true`.
-             *
-             * @warning Untested!
-             * @todo Possible optimization: swap groups so that `g1<g2`;
+             * rarely used. To activate `g2g()`, set `CrossGroupBonds=true`.
              */
         double g2g( const Tpvec &p, Group &g1, Group &g2 ) override
         {
             double u = 0;
             if ( CrossGroupBonds )
+            {
+                rebuild();
                 for ( auto i : g1 )
-                {
-                    auto eqr = this->mlist.equal_range(i);
-                    for ( auto it = eqr.first; it != eqr.second; ++it )
-                    {
-                        int j = it->second; // partner index
-                        if ( g2.find(j))
-                            u += this->list[opair<int>(i, j)](
-                                p[i], p[j], spc->geo.sqdist(p[i], p[j]));
-                    }
-                }
+                    for ( int k = offset[i]; k < offset[i + 1]; k++ )
+                        if ( g2.find(neighbours[k].j))
+                            u += energy(p, i, neighbours[k]);
+            }
             return u;
         }
 
@@ -1216,44 +2321,23 @@ namespace Faunus
              */
         double g_internal( const Tpvec &p, Group &g ) override
         {
+            rebuild();
             double u = 0;
-            if ( this->list.size() > pow(g.size(), 2))
-            {
-                // small group compared to bond list
-                auto end = this->list.end();
-                for ( auto i = g.front(); i < g.back(); i++ )
-                    for ( auto j = i + 1; j <= g.back(); j++ )
-                    {
-                        auto it = this->list.find(opair<int>(i, j));
-                        if ( it != end )
-                            u += it->second(p[i], p[j], spc->geo.sqdist(p[i], p[j]));
-                    }
-            }
-            else
-            {
-                // big group compared to bond list
-                for ( auto &m : this->list )
-                {
-                    int i = m.first.first, j = m.first.second;
-                    if ( g.find(i))
-                        if ( g.find(j))
-                            u += m.second(p[i], p[j], spc->geo.sqdist(p[i], p[j]));
-                }
-            }
+            for ( auto i : g )
+                for ( int k = offset[i]; k < offset[i + 1]; k++ )
+                    if ( neighbours[k].j > i && g.find(neighbours[k].j))
+                        u += energy(p, i, neighbours[k]);
             return u;
         }
 
+        /** @brief Add bond between particles `i` and `j` (absolute index) */
         template<class Tpairpot>
         void add( int i, int j, Tpairpot pot )
         {
-            std::ostringstream o;
-            o << textio::indent(textio::SUBSUB) << std::left << setw(7) << i
-              << setw(7) << j << pot.brief() + "\n";
-            _infolist += o.str();
+            _infolist += infoLine(i, j, pot);
             pot.name.clear();   // potentially save a little bit of memory
-            Tbase::add(i, j, pot);// create and add functor to pair list
-            force_list[typename Tbase::Tpair(i, j)]
-                = ForceFunctionObject<decltype(pot)>(pot);
+            bonds.push_back(Bond{nullptr, i, j, store(pot)});
+            dirty = true;
         }
 
         /** @brief Add harmonic bond */
@@ -1267,22 +2351,30 @@ namespace Faunus
         void add( const std::vector<Group *> &groups )
         {
             for ( auto g : groups )
-                if ( g->molId < spc->molecule.size())
-                    for ( auto b : spc->molecule[g->molId].getBondList())
-                    {
-                        b.shift(g->front());
-                        add(b);
-                    }
+                addMolecularBonds(g, true);
         }
 
-        /** @brief Get list of bonds */
-        auto getBondList() -> decltype(this->list) { return Tbase::getBondList(); }
+        /** @brief Get list of bonds (absolute indices) */
+        const vector<std::pair<opair<int>, Entry>> &getBondList()
+        {
+            if ( spc != nullptr )
+                rebuild();
+            return bondlist;
+        }
 
         /** @brief Reset and clear all bonds */
         void clear()
         {
             _infolist.clear();
-            Tbase::clear();
+            pots = decltype(pots)();
+            generic.clear();
+            genericForce.clear();
+            bonds.clear();
+            molecular.clear();
+            bondlist.clear();
+            offset.clear();
+            neighbours.clear();
+            dirty = true;
         }
 
     };
@@ -1320,6 +2412,8 @@ namespace Faunus
         {
             return usum;
         }
+
+        double externalChange( const typename Tspace::Change & ) override { return 0; }
     };
 
 /**
@@ -1414,6 +2508,9 @@ namespace Faunus
             return P * V - log(V);
         }
 
+        /** @brief Zero as `external()` depends on the current volume only */
+        double externalChange( const typename Tspace::Change & ) override { return 0; }
+
         double g_external( const Tpvec &p, Group &g ) override
         {
             // should this group be ignored?
@@ -1712,8 +2809,7 @@ namespace Faunus
     private:
         typedef Energybase<Tspace> base;
         typedef typename Tspace::p_vec Tpvec;
-        typedef std::map<int, Average < double> >
-        Tuofr;
+        typedef BinnedTable<double, Average<double> > Tuofr;
 
         std::map<string, Tuofr> uofr; // sasa energy vs. group-2-group distance
 
@@ -1782,8 +2878,7 @@ namespace Faunus
             {
                 std::ofstream f(pfx + "Usasa_" + i.first);
                 if ( f )
-                    for ( auto &j : i.second )
-                        f << j.first * dr << " " << j.second << "\n";
+                    i.second.forEach([&]( double r, const Average<double> &u ) { f << r << " " << u << "\n"; });
             }
         }
 
@@ -1844,7 +2939,10 @@ namespace Faunus
                         {
                             double r = base::spc->geo.dist(g1.cm, g2.cm);
                             auto k = std::minmax(g1.name, g2.name);
-                            uofr[k.first + "-" + k.second][to_bin(r, dr)] += -tension * dsasa;
+                            auto it = uofr.find(k.first + "-" + k.second);
+                            if ( it == uofr.end())
+                                it = uofr.insert({k.first + "-" + k.second, Tuofr(dr)}).first;
+                            it->second(r) += -tension * dsasa;
                         }
                     }
 
@@ -2515,20 +3613,29 @@ namespace Faunus
      * @brief Energy class for manybody interactions such as dihedrals and angular potentials
      *
      * This is a general class for interactions that can involve
-     * any number of atoms.
+     * any number of atoms. Harmonic angles and cosine dihedrals are
+     * stored in flat, typed arrays,
+     *
+     * - angle: \f$ u = \frac{k}{2}(\theta-\theta_{eq})^2 \f$
+     * - dihedral: \f$ u = k(1+\cos(n\phi-\phi_0)) \f$
+     *
+     * while arbitrary terms may be added as function objects with `add()`.
      *
      * In the following example we add an angular potential between
-     * particle index 3,4,5:
+     * particle index 3,4,5 and a dihedral between 3,4,5,6:
      *
      * ~~~~
-     * Manybody<Tspace> pot;
-     * pot.add( Potential::Angular( {3,4,5}, 70., 0.5 ) );
+     * Manybody<Tspace> pot(spc);
+     * pot.addAngle( 3, 4, 5, 0.5, 70. );         // k (kT/rad^2), angle (deg)
+     * pot.addDihedral( 3, 4, 5, 6, 1.0, 0., 3 ); // k (kT), phase (deg), multiplicity
      * ~~~~
      *
-     * @todo Currently implemented as `external()` which means
-     * that all added potentials are evaluated for each move
-     * eventhough only a subset of atoms are touched. Implement
-     * dictionary to speed up.
+     * An atom-to-term index in compressed sparse row format is used so that
+     * only terms touching a given atom are evaluated. Terms with all atoms
+     * in the same group are accounted for by `i_internal()` and
+     * `g_internal()`; terms spanning several groups by `external()` and
+     * `externalChange()`. Each term is thus counted exactly once in the
+     * system energy.
      */
     template<class Tspace>
     class Manybody : public Energybase<Tspace>
@@ -2538,42 +3645,261 @@ namespace Faunus
 
         string _info() override
         {
-            return _infosum;
+            std::ostringstream o;
+            o << textio::pad(textio::SUB, 25, "Angles") << angles.k.size() << "\n"
+              << textio::pad(textio::SUB, 25, "Dihedrals") << dihedrals.k.size() << "\n"
+              << textio::pad(textio::SUB, 25, "Inter-group terms") << numInter << "\n";
+            return o.str() + _infosum;
         }
 
         typedef Energybase<Tspace> Tbase;
         typedef typename Tbase::Tpvec Tpvec;
 
         typedef std::function<double( typename Tbase::Tgeometry &, const Tpvec & )> EnergyFunct;
-        vector <EnergyFunct> list;
-        std::set<int> allindex; // index of all particles involved
+
+        struct AngleArrays
+        {
+            vector<int> index;           // i,j,k with j as vertex (3 per term)
+            vector<double> k, aeq;       // force constant (kT/rad^2), equilibrium angle (rad)
+        } angles;
+
+        struct DihedralArrays
+        {
+            vector<int> index;           // i,j,k,l (4 per term)
+            vector<double> k, phi0;      // force constant (kT), phase (rad)
+            vector<int> n;               // multiplicity
+        } dihedrals;
+
+        vector<EnergyFunct> list;        // arbitrary terms
+        vector<vector<int>> listindex;   // particle index of arbitrary terms
+
+        // term id t: [0,Na) angles, [Na,Na+Nd) dihedrals, then `list`
+        vector<int> offset;              // CSR row offsets for each particle
+        vector<int> terms;               // CSR term ids
+        vector<char> inter;              // true if term spans several groups
+        vector<char> mark;               // scratch for unique term selection
+        vector<int> selected;            // scratch
+        bool dirty;
+        size_t numInter, np, ng;         // inter-group terms; particles and groups at last build
+
+        size_t size() const { return angles.k.size() + dihedrals.k.size() + list.size(); }
+
+        /** @brief Particle index of term `t` */
+        template<class Tfunc>
+        void forEachIndex( int t, Tfunc f ) const
+        {
+            int na = angles.k.size(), nd = dihedrals.k.size();
+            if ( t < na )
+                for ( int m = 0; m < 3; m++ )
+                    f(angles.index[3 * t + m]);
+            else if ( t < na + nd )
+                for ( int m = 0; m < 4; m++ )
+                    f(dihedrals.index[4 * (t - na) + m]);
+            else
+                for ( auto i : listindex[t - na - nd] )
+                    f(i);
+        }
+
+        /** @brief (Re)build atom-to-term index and group classification */
+        void buildIndex()
+        {
+            auto &spc = Tbase::getSpace();
+            if ( !dirty && np == spc.p.size() && ng == spc.groupList().size())
+                return;
+            int nterms = size(), nmax = 0;
+            for ( int t = 0; t < nterms; t++ )
+                forEachIndex(t, [&]( int i ) { nmax = std::max(nmax, i + 1); });
+            nmax = std::max<int>(nmax, spc.p.size());
+            offset.assign(nmax + 1, 0);
+            for ( int t = 0; t < nterms; t++ )
+                forEachIndex(t, [&]( int i ) { offset[i + 1]++; });
+            for ( int i = 0; i < nmax; i++ )
+                offset[i + 1] += offset[i];
+            terms.resize(offset.back());
+            vector<int> fill(offset.begin(), offset.end() - 1);
+            inter.assign(nterms, 0);
+            numInter = 0;
+            for ( int t = 0; t < nterms; t++ )
+            {
+                Group *g0 = nullptr;
+                bool first = true, spans = false;
+                forEachIndex(t, [&]( int i )
+                {
+                    terms[fill[i]++] = t;
+                    Group *g = spc.findGroup(i);
+                    if ( first )
+                        g0 = g;
+                    else if ( g != g0 )
+                        spans = true;
+                    first = false;
+                });
+                inter[t] = (spans || g0 == nullptr);
+                numInter += inter[t];
+            }
+            mark.assign(nterms, 0);
+            np = spc.p.size();
+            ng = spc.groupList().size();
+            dirty = false;
+        }
+
+        /** @brief Energy of term `t` */
+        double term( int t, const Tpvec &p )
+        {
+            auto &geo = Tbase::getSpace().geo;
+            int na = angles.k.size(), nd = dihedrals.k.size();
+            if ( t < na )
+            {
+                const int *n = &angles.index[3 * t];
+                Point a = geo.vdist(p[n[0]], p[n[1]]);
+                Point b = geo.vdist(p[n[2]], p[n[1]]);
+                double c = a.dot(b) / std::sqrt(a.squaredNorm() * b.squaredNorm());
+                double da = std::acos(std::max(-1.0, std::min(1.0, c))) - angles.aeq[t];
+                return 0.5 * angles.k[t] * da * da;
+            }
+            t -= na;
+            if ( t < nd )
+            {
+                const int *n = &dihedrals.index[4 * t];
+                Point b1 = geo.vdist(p[n[1]], p[n[0]]);
+                Point b2 = geo.vdist(p[n[2]], p[n[1]]);
+                Point b3 = geo.vdist(p[n[3]], p[n[2]]);
+                Point n1 = b1.cross(b2), n2 = b2.cross(b3);
+                double phi = std::atan2(n1.cross(n2).dot(b2) / b2.norm(), n1.dot(n2));
+                return dihedrals.k[t] * (1 + std::cos(dihedrals.n[t] * phi - dihedrals.phi0[t]));
+            }
+            return list[t - nd](geo, p);
+        }
+
+        /** @brief Select unique terms touching particles in `index` and pass `inter`/intra filter */
+        template<class Tindex>
+        void select( const Tindex &index, bool wantInter )
+        {
+            for ( auto i : index )
+                if ( i >= 0 && i + 1 < (int) offset.size())
+                    for ( int m = offset[i]; m < offset[i + 1]; m++ )
+                    {
+                        int t = terms[m];
+                        if ( !mark[t] && bool(inter[t]) == wantInter )
+                        {
+                            mark[t] = 1;
+                            selected.push_back(t);
+                        }
+                    }
+        }
+
+        /** @brief Sum selected terms and reset selection */
+        double sumSelected( const Tpvec &p )
+        {
+            double u = 0;
+            for ( auto t : selected )
+            {
+                u += term(t, p);
+                mark[t] = 0;
+            }
+            selected.clear();
+            return u;
+        }
 
     public:
-        Manybody( Tspace &spc )
+        Manybody( Tspace &spc ) : dirty(true), numInter(0), np(0), ng(0)
         {
             Tbase::name = "Manybody potential";
             Tbase::setSpace(spc);
         }
 
         /**
-               * @brief Add a manybody potential
-               */
+         * @brief Add harmonic angle with `j` as vertex
+         * @param k Force constant (kT/rad^2)
+         * @param angle Equilibrium angle (degrees)
+         */
+        void addAngle( int i, int j, int k, double kforce, double angle )
+        {
+            angles.index.insert(angles.index.end(), {i, j, k});
+            angles.k.push_back(kforce);
+            angles.aeq.push_back(angle * pc::pi / 180);
+            dirty = true;
+        }
+
+        /**
+         * @brief Add cosine dihedral between `i`,`j`,`k`,`l`
+         * @param k Force constant (kT)
+         * @param phase Phase (degrees)
+         * @param n Multiplicity
+         */
+        void addDihedral( int i, int j, int k, int l, double kforce, double phase, int n = 1 )
+        {
+            dihedrals.index.insert(dihedrals.index.end(), {i, j, k, l});
+            dihedrals.k.push_back(kforce);
+            dihedrals.phi0.push_back(phase * pc::pi / 180);
+            dihedrals.n.push_back(n);
+            dirty = true;
+        }
+
+        /**
+         * @brief Add an arbitrary manybody potential
+         *
+         * `Tmanybodypot` must provide `brief()`, `getIndex()` and
+         * `operator()(geometry, particle vector)`.
+         */
         template<class Tmanybodypot>
         void add( const Tmanybodypot &f )
         {
             list.push_back(f);
+            listindex.push_back(vector<int>(f.getIndex().begin(), f.getIndex().end()));
             _infosum += "  " + f.brief() + "\n";
-            for ( auto i : f.getIndex())
-                allindex.insert(i);
+            dirty = true;
+        }
+
+        /** @brief Terms with atom `i` in the same group */
+        double i_internal( const Tpvec &p, int i ) override
+        {
+            buildIndex();
+            select(std::array<int, 1>{{i}}, false);
+            return sumSelected(p);
+        }
+
+        /** @brief Terms with all atoms in group `g` */
+        double g_internal( const Tpvec &p, Group &g ) override
+        {
+            buildIndex();
+            select(g, false);
+            return sumSelected(p);
         }
 
+        /** @brief Terms spanning several groups */
         double external( const Tpvec &p ) override
         {
+            buildIndex();
             double u = 0;
-            for ( auto &f : list )
-                u += f(Tbase::spc->geo, p);
+            if ( numInter > 0 )
+                for ( int t = 0; t < (int) inter.size(); t++ )
+                    if ( inter[t] )
+                        u += term(t, p);
             return u;
         }
+
+        /** @brief Change in inter-group terms touching moved particles */
+        double externalChange( const typename Tspace::Change &c ) override
+        {
+            buildIndex();
+            if ( numInter == 0 )
+                return 0;
+            if ( c.geometryChange || !c.rmGroup.empty() || !c.inGroup.empty())
+                return Tbase::externalChange(c);
+            auto &spc = Tbase::getSpace();
+            for ( auto &m : c.mvGroup )
+                if ( m.second.empty())
+                    select(*spc.groupList().at(m.first), true);
+                else
+                    select(m.second, true);
+            double du = 0;
+            for ( auto t : selected )
+                du += term(t, spc.trial) - term(t, spc.p);
+            for ( auto t : selected )
+                mark[t] = 0;
+            selected.clear();
+            return du;
+        }
     };
 
 #ifdef FAU_POWERSASA
@@ -2873,6 +4199,26 @@ class SASAEnergy : public Energybase<Tspace> {
             return u;
         }
 
+        double externalChange( const typename Tspace::Change &c ) override
+        {
+            double u = 0;
+            for ( auto b : baselist )
+                u += b->externalChange(c);
+            return u;
+        }
+
+        void prepare() override
+        {
+            for ( auto b : baselist )
+                b->prepare();
+        }
+
+        void refresh() override
+        {
+            for ( auto b : baselist )
+                b->refresh();
+        }
+
         double v2v( const Tpvec &v1, const Tpvec &v2 ) override
         {
             double u = 0;
@@ -2910,6 +4256,295 @@ class SASAEnergy : public Energybase<Tspace> {
         }
     };
 
+    /**
+     * @brief Running total system energy
+     *
+     * Keeps the total energy as the last full evaluation plus the energy
+     * changes reported by moves, see `Move::Propagator::runningEnergy()`.
+     * Every `resyncInterval` calls to `add()`, the total is recomputed with
+     * the full energy function and the largest deviation found is kept in
+     * `maxDrift()`. This lets moves needing the current total energy, such
+     * as `Move::ParallelTempering`, skip a full evaluation.
+     */
+    class RunningEnergy
+    {
+    private:
+        std::function<double()> ufull;
+        double u, drift;
+        bool valid;
+        unsigned long cnt;
+
+    public:
+        unsigned long resyncInterval; //!< Full evaluation every n'th `add()` (0=never)
+
+        RunningEnergy( std::function<double()> f = nullptr, unsigned long interval = 1000 )
+            : ufull(f), u(0), drift(0), valid(false), cnt(0), resyncInterval(interval) {}
+
+        /** @brief Set function for full energy evaluation */
+        void setFunction( std::function<double()> f )
+        {
+            ufull = f;
+            valid = false;
+        }
+
+        /** @brief Recompute total energy; returns it */
+        double resync()
+        {
+            assert(ufull && "Energy function not set");
+            double ucurr = ufull();
+            if ( valid )
+                drift = std::max(drift, std::fabs(ucurr - u));
+            u = ucurr;
+            valid = true;
+            cnt = 0;
+            return u;
+        }
+
+        /** @brief Current total energy (kT) */
+        double current() { return valid ? u : resync(); }
+
+        /** @brief Add energy change from a move */
+        void add( double du )
+        {
+            if ( !valid )
+                return;
+            u += du;
+            if ( resyncInterval > 0 && ++cnt >= resyncInterval )
+                resync();
+        }
+
+        /** @brief Force full evaluation on next request, e.g. after untracked changes */
+        void invalidate() { valid = false; }
+
+        /** @brief Largest absolute deviation found on resync (kT) */
+        double maxDrift() const { return drift; }
+    };
+
+    /**
+     * @brief Energy change between moved groups and all other groups, evaluated in parallel
+     *
+     * Work is split into one task per static group, each summing `g2g()`
+     * with all moved groups in `Space::trial` and `Space::p`. With OpenMP
+     * the tasks are distributed over the (persistent) thread team;
+     * per-group results are stored and summed in group order so that the
+     * result does not depend on the number of threads. Pairs between
+     * moved groups are not included.
+     *
+     * Before the parallel loop, `Energybase::prepare()` lets energy terms
+     * that lazily rebuild internal data, such as the cells of
+     * `NonbondedCellList` or the bond list of `Bonded`, do so on a single
+     * thread. Terms that modify their state on every `g2g()` call cannot
+     * be used.
+     *
+     * Example:
+     *
+     *     Energy::ParallelGroupEnergy<Tspace> par;
+     *     double du = par.change(pot, spc, {g1, g2});
+     */
+    template<class Tspace>
+    class ParallelGroupEnergy
+    {
+    private:
+        std::vector<double> du;     // energy change per static group
+        std::vector<char> moved;    // true if group is moved
+
+    public:
+        /** @brief Energy change (kT) between `mv` and all other groups; infinity if any new pair is */
+        double change( Energybase<Tspace> &pot, Tspace &spc, const std::vector<Group *> &mv )
+        {
+            auto &g = spc.groupList();
+            int n = g.size();
+            du.assign(n, 0);
+            moved.assign(n, 0);
+            for ( auto m : mv )
+                moved[spc.findIndex(m)] = 1;
+
+            pot.prepare(); // lazy rebuilds on a single thread
+#pragma omp parallel for schedule (dynamic)
+            for ( int j = 0; j < n; j++ )
+                if ( !moved[j] )
+                {
+                    double unew = 0, uold = 0;
+                    for ( auto m : mv )
+                    {
+                        unew += pot.g2g(spc.trial, *m, *g[j]);
+                        uold += pot.g2g(spc.p, *m, *g[j]);
+                    }
+                    du[j] = (unew == pc::infty) ? pc::infty : unew - uold;
+                }
+
+            double sum = 0;
+            for ( int j = 0; j < n; j++ )
+            {
+                if ( du[j] == pc::infty )
+                    return pc::infty;
+                sum += du[j];
+            }
+            return sum;
+        }
+    };
+
+    /**
+     * @brief Cache of group-to-group energies
+     *
+     * Holds the symmetric matrix of `g2g()` energies between all groups
+     * in `Space::p`. Moves that are given the cache with
+     * `Move::Movebase::setPairCache()` evaluate only the trial energies
+     * of moved groups and take the old energies from the cache; the move
+     * commits the new rows on acceptance and discards them on rejection.
+     * Rows of groups moved by other moves, found in `Space::Change`, are
+     * marked on acceptance and recomputed at the next request, so that a
+     * series of, say, single particle moves in a large atomic group costs a
+     * single row. Insertions, removals, geometry changes and moves that
+     * leave `Space::Change` empty cause a full rebuild at the next request.
+     *
+     * Example:
+     *
+     *     Energy::GroupPairCache<Tspace> cache(pot, spc);
+     *     mv.setPairCache(cache);
+     *     double u12 = cache(1,2);       // energy between groups 1 and 2
+     *     double u = cachedSystemEnergy(spc, pot, cache);
+     */
+    template<class Tspace>
+    class GroupPairCache
+    {
+    private:
+        typedef typename Tspace::ParticleVector Tpvec;
+        Energybase<Tspace> *pot;
+        Tspace *spc;
+        Eigen::MatrixXd u;                  // energies in `Space::p`
+        Eigen::MatrixXd utrial;             // energies in `Space::trial` after `trialTotal()`
+        std::map<int, Eigen::VectorXd> rows; // trial rows after `rowChange()`
+        std::set<int> stale;                // rows to recompute before use
+        bool valid, trialAll;
+        unsigned long layout;
+
+        /** @brief Recompute stale rows from `Space::p`; pairs of two stale rows only once */
+        void refreshRows()
+        {
+            auto &g = spc->groupList();
+            for ( auto i : stale )
+                for ( int j = 0; j < (int) g.size(); j++ )
+                    if ( j != i && (j > i || stale.count(j) == 0))
+                        u(i, j) = u(j, i) = pot->g2g(spc->p, *g[i], *g[j]);
+            stale.clear();
+        }
+
+    public:
+        GroupPairCache( Energybase<Tspace> &e, Tspace &s ) : pot(&e), spc(&s), valid(false), trialAll(false), layout(0) {}
+
+        /** @brief Invalidate such that the matrix is rebuilt on next use */
+        void invalidate() { valid = false; }
+
+        /** @brief Rebuild full matrix from `Space::p` if invalid, otherwise recompute stale rows */
+        void rebuild()
+        {
+            if ( valid && layout == spc->layoutCount())
+            {
+                if ( !stale.empty())
+                    refreshRows();
+                return;
+            }
+            stale.clear();
+            auto &g = spc->groupList();
+            int n = g.size();
+            u.setZero(n, n);
+            for ( int i = 0; i < n - 1; i++ )
+                for ( int j = i + 1; j < n; j++ )
+                    u(i, j) = u(j, i) = pot->g2g(spc->p, *g[i], *g[j]);
+            layout = spc->layoutCount();
+            valid = true;
+        }
+
+        /** @brief Energy between groups `i` and `j` in `Space::p` (kT) */
+        double operator()( int i, int j )
+        {
+            rebuild();
+            return u(i, j);
+        }
+
+        /** @brief Matrix of all group-to-group energies in `Space::p` (kT) */
+        const Eigen::MatrixXd &matrix()
+        {
+            rebuild();
+            return u;
+        }
+
+        /** @brief Sum of all group-to-group energies in `Space::p` (kT) */
+        double total()
+        {
+            rebuild();
+            return 0.5 * u.sum();
+        }
+
+        /**
+         * @brief Energy change of group `i` with all other groups
+         *
+         * The new row is evaluated in `Space::trial` and kept until `update()`.
+         * Returns infinity as soon as a single pair does.
+         */
+        double rowChange( int i )
+        {
+            rebuild();
+            auto &g = spc->groupList();
+            Eigen::VectorXd r(g.size());
+            double du = 0;
+            for ( int j = 0; j < (int) g.size(); j++ )
+            {
+                r[j] = (j == i) ? 0 : pot->g2g(spc->trial, *g[i], *g[j]);
+                if ( r[j] == pc::infty )
+                    return pc::infty;
+                du += r[j] - u(i, j);
+            }
+            rows[i] = r;
+            return du;
+        }
+
+        /** @brief Sum of all group-to-group energies in `Space::trial`, kept until `update()` */
+        double trialTotal()
+        {
+            rebuild();
+            auto &g = spc->groupList();
+            int n = g.size();
+            utrial.setZero(n, n);
+            for ( int i = 0; i < n - 1; i++ )
+                for ( int j = i + 1; j < n; j++ )
+                    utrial(i, j) = utrial(j, i) = pot->g2g(spc->trial, *g[i], *g[j]);
+            trialAll = true;
+            return 0.5 * utrial.sum();
+        }
+
+        /**
+         * @brief Commit or discard trial energies after a move
+         *
+         * Called by `Move::Movebase::move()` once `Space::p` has been updated.
+         */
+        void update( bool acceptance, const typename Tspace::Change &c )
+        {
+            if ( acceptance && valid )
+            {
+                if ( trialAll )
+                    u.swap(utrial);
+                else if ( c.geometryChange || !c.rmGroup.empty() || !c.inGroup.empty() || c.empty())
+                    valid = false;
+                else
+                    for ( auto &m : c.mvGroup )
+                    {
+                        auto it = rows.find(m.first);
+                        if ( it == rows.end())
+                            stale.insert(m.first);
+                        else
+                        {
+                            u.row(m.first) = it->second.transpose();
+                            u.col(m.first) = it->second;
+                        }
+                    }
+            }
+            rows.clear();
+            trialAll = false;
+        }
+    };
+
     /**
      * @brief Calculates the total system energy
      *
@@ -2933,6 +4568,17 @@ class SASAEnergy : public Energybase<Tspace> {
                 u += pot.g2g(p, *spc.groupList()[i], *spc.groupList()[j]);
         return u;
     }
+
+    /** @brief As `systemEnergy()` for `Space::p` but with group-to-group energies taken from a cache */
+    template<class Tspace, class Tenergy>
+    double cachedSystemEnergy( Tspace &spc, Tenergy &pot, GroupPairCache<Tspace> &cache )
+    {
+        pot.setSpace(spc);
+        double u = pot.external(spc.p) + cache.total();
+        for ( auto g : spc.groupList())
+            u += pot.g_external(spc.p, *g) + pot.g_internal(spc.p, *g);
+        return u;
+    }
     
       /**
        * @brief Help-funciton to 'energyChange'
@@ -5,6 +5,7 @@
 #include "faunus/inputfile.h"
 #include <faunus/tabulate.h>
 #include <complex>
+#include <unsupported/Eigen/FFT>
 
 namespace Faunus {
 
@@ -227,14 +228,23 @@ namespace Faunus {
 	  typedef typename Tbase::Tgeometry Tgeometry;
 
 	  EwaldParameters<useIonIon,useIonDipole,useDipoleDipole> parameters;
-          int kVectorsInUse, kVectorsInUse_trial, N, cnt_accepted, update_frequency;
+          int kVectorsInUse, N, cnt_accepted, update_frequency;
           double V, V_trial, surfaceEnergy, surfaceEnergyTrial, reciprocalEnergy, reciprocalEnergyTrial, eps_surf, const_inf, lB, update_drift; 
+          Point qrs, mus, qrs_trial, mus_trial; // total charge and dipole moments for the surface term
           bool spherical_sum, isotropic_pbc;
+          bool pending;       // true if trial structure factors differ from the accepted ones
+          bool trialGeometry; // true if trial k-vectors were generated for a trial geometry
+          bool stale;         // true if trial structure factors await the trial geometry
+          bool trialMoments;  // true if `qrs_trial` and `mus_trial` were evaluated for the trial
           vector<complex<double>> Q_ion_tot, Q_dip_tot, Q_ion_tot_trial, Q_dip_tot_trial;
           typename Tspace::Change change;
 
           Eigen::MatrixXd kVectors, kVectors_trial;  // Matrices with k-vectors
+          Eigen::MatrixXi kIndex;                    // Integer lattice, n, of k-vectors (independent of volume)
+          Point kUnit, kUnit_trial;                  // 2*pi/L, i.e. k = n * kUnit
+          Point len, len_trial;                      // Box side lengths of the above
           Eigen::VectorXd Aks, Aks_trial;  // Stores values based on k-vectors in order to minimize computational effort. (See Eq.24 in DOI: 10.1063/1.481216)
+          mutable vector<complex<double>> eik[3];    // exp(i*n*kUnit*r) for n=0...kcc in each dimension
           
           /**
            * @brief Returns Ewald self energy in kT for ions and dipoles.
@@ -265,14 +275,26 @@ namespace Faunus {
 		return 0.0;
               Point mus(0,0,0);
               Point qrs(0,0,0);
+              addDipoleMoment(p, g, qrs, mus);
+              return getSurfaceEnergy(qrs, mus, V_in);
+            }
+
+          /** @brief Returns Ewald surface energy in kT from total charge and dipole moments */
+          double getSurfaceEnergy(const Point &qrs, const Point &mus, double V_in) const {
+	    if(const_inf < 0.5)
+	      return 0.0;
+            return const_inf * (2*pc::pi/(( 2*eps_surf + 1)*V_in))*( qrs.dot(qrs) + 2*qrs.dot(mus) +  mus.dot(mus) )*lB;
+          }
+
+          /** @brief Adds charge and dipole moments of group `g` to `qrs` and `mus` */
+          template<class Tpvec, class Tgroup>
+            void addDipoleMoment(const Tpvec &p, const Tgroup &g, Point &qrs, Point &mus, double sign=1.0) const {
               for (auto i : g) {  
                 if (useIonIon || useIonDipole)
-                  qrs = qrs + p[i].charge*p[i];
+                  qrs = qrs + sign*p[i].charge*p[i];
                 if (useIonDipole || useDipoleDipole)
-                  mus = mus + p[i].mu()*p[i].muscalar();
+                  mus = mus + sign*p[i].mu()*p[i].muscalar();
               }
-              
-              return const_inf * (2*pc::pi/(( 2*eps_surf + 1)*V_in))*( qrs.dot(qrs) + 2*qrs.dot(mus) +  mus.dot(mus) )*lB;
             }
 
           /**
@@ -285,11 +307,11 @@ namespace Faunus {
             for (size_t k=0; k < Q_ion_tot_in.size(); k++) {
               double Q2 = 0.0;
               if(useIonIon)
-                Q2 += std::norm(Q_ion_tot_in.at(k));  // 'norm' returns squared magnitude
+                Q2 += std::norm(Q_ion_tot_in[k]);  // 'norm' returns squared magnitude
               if(useIonDipole)
-                Q2 += 2.0*std::real(Q_ion_tot_in.at(k)*Q_dip_tot_in.at(k));
+                Q2 += 2.0*std::real(Q_ion_tot_in[k]*Q_dip_tot_in[k]);
               if(useDipoleDipole)
-                Q2 += std::norm(Q_dip_tot_in.at(k));  // 'norm' returns squared magnitude
+                Q2 += std::norm(Q_dip_tot_in[k]);  // 'norm' returns squared magnitude
               E += ( Aks_in[k] * Q2 );
             }
             return (2*pc::pi/V_in)*E*lB;
@@ -309,88 +331,143 @@ namespace Faunus {
 	    }
 
           /**
-           * @brief Updates all vectors and matrices which depends on the number of k-space vectors.
-           * @note Needs to be called whenever 'kcc_x', 'kcc_y' or 'kcc_z' has been updated
+           * @brief Generates the integer lattice, n, of k-vectors and resizes the structure factors
+           * @note Needs to be called whenever 'kcc' has been updated. The lattice does not depend
+           *       on the box so volume changes only need `kVectorScale()`.
            */
-          void kVectorChange(Eigen::MatrixXd &kVectors_in, Eigen::VectorXd &Aks_in, vector<complex<double>> &Q_ion_tot_in, vector<complex<double>> &Q_dip_tot_in, int &kVectorsInUse_in, EwaldParameters<useIonIon,useIonDipole,useDipoleDipole> &parameters_in) const {
-	    int kVectorsLength = (2*parameters_in.kcc + 1)*(2*parameters_in.kcc + 1)*(2*parameters_in.kcc + 1) - 1;
+          void kLatticeChange() {
+	    int kVectorsLength = (2*parameters.kcc + 1)*(2*parameters.kcc + 1)*(2*parameters.kcc + 1) - 1;
 	    if(kVectorsLength == 0) {
-	      kVectors_in.resize(3, 1); 
-	      Aks_in.resize(1);
-	      kVectors_in.col(0) = Point(1.0,0.0,0.0); // Just so it is not the zero-vector
-	      Aks_in[0] = 0.0;
-	      kVectorsInUse_in = 1;
-	      Q_ion_tot_in.resize(1);
-	      Q_dip_tot_in.resize(1);
-	      return;
-	    }
-            kVectors_in.resize(3, kVectorsLength); 
-            Aks_in.resize(kVectorsLength);
-            kVectorsInUse_in = 0;
-            kVectors_in.setZero();
-            Aks_in.setZero();
-	    int startValue = 1 - int(isotropic_pbc);
-
-            double factor = 1.0;
-            for (int kx = 0; kx <= parameters_in.kcc; kx++) {
-              if(kx > 0)
-                factor = 2.0;
-              double dkx2 = double(kx*kx);
-              for (int ky = -parameters_in.kcc*startValue; ky <= parameters_in.kcc; ky++) {
-                double dky2 = double(ky*ky);
-                for (int kz = -parameters_in.kcc*startValue; kz <= parameters_in.kcc; kz++) {
-                  double dkz2 = double(kz*kz);
-                  Point kv = 2*pc::pi*Point(kx/parameters_in.L.x(),ky/parameters_in.L.y(),kz/parameters_in.L.z());
-                  double k2 = kv.dot(kv);
-                  if (k2 < parameters_in.check_k2_zero) // Check if k2 != 0
-                    continue;
-                  if(spherical_sum)
-                    if( (dkx2/parameters_in.kc2) + (dky2/parameters_in.kc2) + (dkz2/parameters_in.kc2) > 1.0)
+	      kIndex.setZero(3, 1); // zero-vector with Aks=0, just so the vectors are not empty
+	      kVectorsInUse = 1;
+	    } else {
+              kIndex.resize(3, kVectorsLength);
+              kVectorsInUse = 0;
+              int startValue = 1 - int(isotropic_pbc);
+              for (int kx = 0; kx <= parameters.kcc; kx++) {
+                double dkx2 = double(kx*kx);
+                for (int ky = -parameters.kcc*startValue; ky <= parameters.kcc; ky++) {
+                  double dky2 = double(ky*ky);
+                  for (int kz = -parameters.kcc*startValue; kz <= parameters.kcc; kz++) {
+                    double dkz2 = double(kz*kz);
+                    if (kx == 0 && ky == 0 && kz == 0)
                       continue;
-                  kVectors_in.col(kVectorsInUse_in) = kv; 
-                  Aks_in[kVectorsInUse_in] = factor*exp(-k2/(4.0*parameters_in.alpha2))/k2;
-                  kVectorsInUse_in++;
+                    if(spherical_sum)
+                      if( (dkx2/parameters.kc2) + (dky2/parameters.kc2) + (dkz2/parameters.kc2) > 1.0)
+                        continue;
+                    kIndex.col(kVectorsInUse++) << kx, ky, kz;
+                  }
                 }
               }
             }
-            Q_ion_tot_in.resize(kVectorsInUse_in);
-            Q_dip_tot_in.resize(kVectorsInUse_in);
+            Q_ion_tot.resize(kVectorsInUse);
+            Q_dip_tot.resize(kVectorsInUse);
+          }
+
+          /**
+           * @brief Scales the integer lattice to k-vectors and prefactors for box side lengths `L`
+           *
+           * This is O(K) and involves no structure factors.
+           */
+          void kVectorScale(const Point &L, Eigen::MatrixXd &kVectors_in, Point &kUnit_in, Eigen::VectorXd &Aks_in) const {
+            kUnit_in = 2*pc::pi*L.cwiseInverse();
+            kVectors_in.resize(3, kVectorsInUse);
+            Aks_in.resize(kVectorsInUse);
+            for (int k=0; k<kVectorsInUse; k++) {
+              Point kv = kIndex.col(k).cast<double>().cwiseProduct(kUnit_in);
+              double k2 = kv.dot(kv);
+              double factor = (kIndex(0,k) > 0) ? 2.0 : 1.0;
+              kVectors_in.col(k) = kv;
+              Aks_in[k] = (k2 > 0) ? factor*exp(-k2/(4.0*parameters.alpha2))/k2 : 0.0;
+            }
           }
           
+          /** @brief Phase factor exp(i*n*kUnit*r) in dimension `d` from tables in `eik` */
+          inline complex<double> phase(int d, int n) const {
+            return (n < 0) ? std::conj(eik[d][-n]) : eik[d][n];
+          }
+
+          /**
+           * @brief Adds `sign` times the contribution of a particle to the structure factors
+           *
+           * Rather than evaluating trigonometric functions for each k-vector, the phase
+           * factors exp(ik.r) are assembled from exp(i*n*kUnit*r) in each dimension which
+           * are generated recursively by complex multiplication.
+           */
+          void addComplexNumbers(const Tparticle &a, double sign, vector<complex<double>> &Q_ion_tot_in, vector<complex<double>> &Q_dip_tot_in, const Eigen::MatrixXd &kVectors_in, const Eigen::MatrixXi &kIndex_in, const Point &kUnit_in, int kVectorsInUse_in) const {
+            for (int d=0; d<3; d++) {
+              eik[d].resize(parameters.kcc + 1);
+              eik[d][0] = 1.0;
+              if (parameters.kcc > 0)
+                eik[d][1] = std::polar(1.0, kUnit_in[d]*a[d]);
+              for (int n=2; n <= parameters.kcc; n++)
+                eik[d][n] = eik[d][n-1] * eik[d][1];
+            }
+            for (int k=0; k<kVectorsInUse_in; k++) {
+              complex<double> ex = phase(0, kIndex_in(0,k));
+              complex<double> ey = phase(1, kIndex_in(1,k));
+              complex<double> ez = phase(2, kIndex_in(2,k));
+              if( useIonIon || useIonDipole ) {
+                if ( !isotropic_pbc )
+                  Q_ion_tot_in[k] += sign * a.charge * (ex * ey * ez);
+                else
+                  Q_ion_tot_in[k] += sign * a.charge * ex.real() * ey.real() * ez.real();
+              }
+              if( useDipoleDipole || useIonDipole ) {
+                Point kv = kVectors_in.col(k);
+                if ( !isotropic_pbc ) {
+                  complex<double> eikr = ex * ey * ez;
+                  Q_dip_tot_in[k] += sign * kv.dot(a.mu()) * a.muscalar() * complex<double>(-eikr.imag(), eikr.real());
+                } else
+                  Q_dip_tot_in[k] += sign * ( ex.imag()*ey.real()*ez.real()*a.mu().x()*kv.x() + ex.real()*ey.imag()*ez.real()*a.mu().y()*kv.y()
+                      + ex.real()*ey.real()*ez.imag()*a.mu().z()*kv.z() ) * a.muscalar();
+              }
+            }
+          }
+
           /**
            * @brief Re-calculates the vectors of complex numbers used in getQ2
            * @param p Particle vector
 	   * @param Q_ion_tot_in Vector of complex numbers for ions
 	   * @param Q_dip_tot_in Vector of complex numbers for dipoles
 	   * @param kVectors_in k-vectors
+	   * @param kIndex_in Integer lattice of k-vectors
+	   * @param kUnit_in Reciprocal unit lengths, 2*pi/L
 	   * @param kVectorsInUse_in Number of k-vectors (not necessarily the same as the length of 'kVectors_in')
            */
-          void updateAllComplexNumbers(const Tpvec &p, vector<complex<double>> &Q_ion_tot_in, vector<complex<double>> &Q_dip_tot_in, const Eigen::MatrixXd &kVectors_in, int kVectorsInUse_in) const {
-	     for (int k=0; k<kVectorsInUse_in; k++) {
-              Point kv = kVectors_in.col(k);
-              complex<double> Q_temp_ion(0.0,0.0);
-              complex<double> Q_temp_dip(0.0,0.0);
-              for (size_t i = 0; i < p.size(); i++) {
-                double dot = kv.dot(p[i]);
-                if( ( useIonIon || useIonDipole ) && !isotropic_pbc ) {
-                  Q_temp_ion += p[i].charge * complex<double>(cos(dot),sin(dot));
-		} else if( ( useIonIon || useIonDipole ) && isotropic_pbc ) {
-		  Q_temp_ion += p[i].charge*cos(kv.x()*p[i].x())*cos(kv.y()*p[i].y())*cos(kv.z()*p[i].z()); 
-		}
-                if(useDipoleDipole && !isotropic_pbc) {
-                  Q_temp_dip += kv.dot(p[i].mu()) * p[i].muscalar() * complex<double>(-sin(dot),cos(dot));
-		} else if(useDipoleDipole && isotropic_pbc) {
-		  double xx = spc->p[i].x()*kv.x();
-		  double yy = spc->p[i].y()*kv.y();
-		  double zz = spc->p[i].z()*kv.z();
-		  double cosX = cos(xx);
-		  double cosY = cos(yy);
-		  double cosZ = cos(zz);
-		  Q_temp_dip += ( sin(xx)*cosY*cosZ*spc->p[i].mu().x()*kv.x() + cosX*sin(yy)*cosZ*spc->p[i].mu().y()*kv.y() + cosX*cosY*sin(zz)*spc->p[i].mu().z()*kv.z() )*spc->p[i].muscalar();
-		}
+          void updateAllComplexNumbers(const Tpvec &p, vector<complex<double>> &Q_ion_tot_in, vector<complex<double>> &Q_dip_tot_in, const Eigen::MatrixXd &kVectors_in, const Eigen::MatrixXi &kIndex_in, const Point &kUnit_in, int kVectorsInUse_in) const {
+            Q_ion_tot_in.assign(kVectorsInUse_in, complex<double>(0.0,0.0));
+            Q_dip_tot_in.assign(kVectorsInUse_in, complex<double>(0.0,0.0));
+            for (auto &a : p)
+              addComplexNumbers(a, 1.0, Q_ion_tot_in, Q_dip_tot_in, kVectors_in, kIndex_in, kUnit_in, kVectorsInUse_in);
+          }
+
+          /**
+           * @brief Trial structure factors after a geometry change
+           *
+           * Ionic structure factors depend only on the scaled coordinates, \f$ {\bf r}_j/L \f$, which
+           * are left untouched when particles are scaled with the box. Only particles whose scaled
+           * coordinates (phases) differ from the accepted ones are therefore re-evaluated, while
+           * k-vectors and `Aks` of the trial box are simple rescalings of the integer lattice.
+           * Dipolar structure factors contain \f$ {\bf k}\cdot{\boldsymbol \mu}_j \f$ and are
+           * recalculated in full if the box has changed.
+           */
+          void scaledComplexNumbers() {
+            const Eigen::MatrixXd &kv = trialGeometry ? kVectors_trial : kVectors;
+            const Point &ku = trialGeometry ? kUnit_trial : kUnit;
+            stale = false;
+            if ( trialGeometry && (useIonDipole || useDipoleDipole) ) {
+              updateAllComplexNumbers(spc->trial, Q_ion_tot_trial, Q_dip_tot_trial, kv, kIndex, ku, kVectorsInUse);
+              return;
+            }
+            Q_ion_tot_trial = Q_ion_tot;
+            Q_dip_tot_trial = Q_dip_tot;
+            for (size_t i=0; i<spc->p.size(); i++) {
+              Point dphase = spc->trial[i].cwiseProduct(ku) - spc->p[i].cwiseProduct(kUnit);
+              if ( dphase.squaredNorm() > 1e-20 ) { // phase unchanged to within rounding
+                addComplexNumbers(spc->trial[i], 1.0, Q_ion_tot_trial, Q_dip_tot_trial, kv, kIndex, ku, kVectorsInUse);
+                addComplexNumbers(spc->p[i], -1.0, Q_ion_tot_trial, Q_dip_tot_trial, kVectors, kIndex, kUnit, kVectorsInUse);
               }
-              Q_ion_tot_in.at(k) = Q_temp_ion;
-              Q_dip_tot_in.at(k) = Q_temp_dip;
             }
           }
 
@@ -492,47 +569,61 @@ namespace Faunus {
             isotropic_pbc = ( _j.value("isotropic_pbc",false) );
 	    Tbase::pairpot.first.updateRcut(parameters.rc);
             Tbase::pairpot.first.updateAlpha(parameters.alpha);
-	    kVectorChange(kVectors,Aks,Q_ion_tot,Q_dip_tot,kVectorsInUse,parameters);
+            pending = trialGeometry = stale = false;
+            len = len_trial = Point(0,0,0);
+            qrs = mus = qrs_trial = mus_trial = Point(0,0,0);
+            trialMoments = false;
+	    kLatticeChange();
           }
           
           /**
-	   * @brief Replaces all trial-entities with the old ones
+	   * @brief Discards trial-entities
+	   *
+	   * Trial structure factors are ignored until the next `updateChange()` so
+	   * nothing but a few scalars are copied.
 	   */
           void undo() {
 	    V_trial = V;
-	    kVectorsInUse_trial = kVectorsInUse;
+            qrs_trial = qrs;
+            mus_trial = mus;
+            trialMoments = false;
 	    surfaceEnergyTrial = surfaceEnergy;
 	    reciprocalEnergyTrial = reciprocalEnergy;
-            Q_ion_tot_trial.resize(kVectorsInUse);
-            Q_dip_tot_trial.resize(kVectorsInUse);
-            kVectors_trial.resize(3, kVectorsInUse); 
-	    Aks_trial.resize(kVectorsInUse); 
-            for (int k=0; k < kVectorsInUse; k++) {
-              Q_ion_tot_trial.at(k) = Q_ion_tot.at(k);
-              Q_dip_tot_trial.at(k) = Q_dip_tot.at(k);
-              kVectors_trial.col(k) = kVectors.col(k);
-              Aks_trial[k] = Aks[k];
-            }
+            pending = trialGeometry = stale = false;
 	  }
 	  
           /**
 	   * @brief Replaces all old-entities with the trial ones
+	   *
+	   * Buffers are swapped rather than copied; k-vectors are swapped
+	   * only if they were generated for a trial geometry.
 	   */
           void accept() {
-	    V = V_trial;
-	    kVectorsInUse = kVectorsInUse_trial;
-	    surfaceEnergy = surfaceEnergyTrial;
-	    reciprocalEnergy = reciprocalEnergyTrial;
-            Q_ion_tot.resize(kVectorsInUse);
-            Q_dip_tot.resize(kVectorsInUse);
-            kVectors.resize(3, kVectorsInUse);
-	    Aks.resize(kVectorsInUse); 
-            for (int k=0; k < kVectorsInUse; k++) {
-              Q_ion_tot.at(k) = Q_ion_tot_trial.at(k);
-              Q_dip_tot.at(k) = Q_dip_tot_trial.at(k);
-              kVectors.col(k) = kVectors_trial.col(k);
-              Aks[k] = Aks_trial[k];
+            if (pending) {
+              if (stale)
+                scaledComplexNumbers();
+              V = V_trial;
+              if (!trialMoments) { // trial energy was not evaluated by `external()` or `externalChange()`
+                Group g(0, spc->trial.size()-1);
+                qrs_trial = mus_trial = Point(0,0,0);
+                addDipoleMoment(spc->trial, g, qrs_trial, mus_trial);
+                surfaceEnergyTrial = getSurfaceEnergy(qrs_trial,mus_trial,V_trial);
+                trialReciprocalEnergy();
+              }
+              qrs = qrs_trial;
+              mus = mus_trial;
+              surfaceEnergy = surfaceEnergyTrial;
+              reciprocalEnergy = reciprocalEnergyTrial;
+              Q_ion_tot.swap(Q_ion_tot_trial);
+              Q_dip_tot.swap(Q_dip_tot_trial);
+              if (trialGeometry) {
+                std::swap(kUnit, kUnit_trial);
+                std::swap(len, len_trial);
+                kVectors.swap(kVectors_trial);
+                Aks.swap(Aks_trial);
+              }
             }
+            undo();
 	  }
 
           /**
@@ -563,17 +654,17 @@ namespace Faunus {
 	    reciprocalEnergyAverage += reciprocalEnergy;
 	    //realEnergyAverage += getRealEnergy(spc->trial); // Takes a lot of time
 	    
+	    accept();
 	    if(++cnt_accepted > update_frequency - 1) {
-	      double duB = getReciprocalEnergy(Q_ion_tot_trial,Q_dip_tot_trial,Aks_trial,V_trial);                        // Calulate with old vectors/matrices
-	      updateAllComplexNumbers(spc->trial, Q_ion_tot_trial, Q_dip_tot_trial, kVectors_trial, kVectorsInUse_trial); // Re-calculate the vectors/matrices
-	      double duA = getReciprocalEnergy(Q_ion_tot_trial,Q_dip_tot_trial,Aks_trial,V_trial);                        // Calulate with new vectors/matrices
-	      accept(); 
+	      double duB = getReciprocalEnergy(Q_ion_tot,Q_dip_tot,Aks,V);                                   // Calulate with old vectors/matrices
+	      updateAllComplexNumbers(spc->trial, Q_ion_tot, Q_dip_tot, kVectors, kIndex, kUnit, kVectorsInUse); // Re-calculate the vectors/matrices
+	      double duA = getReciprocalEnergy(Q_ion_tot,Q_dip_tot,Aks,V);                                   // Calulate with new vectors/matrices
+	      reciprocalEnergy = reciprocalEnergyTrial = duA;
 	      cnt_accepted = 0;
 	      update_drift += fabs(duA - duB);
 	      change.clear();
 	      return (duA - duB);
 	    }
-	    accept();
 	    change.clear();
 	    return 0.0;
           }
@@ -583,56 +674,30 @@ namespace Faunus {
            */
           double updateChange(const typename Tspace::Change &c) override {
             change = c;
+            pending = true;
 
+            // The trial box may not yet be known, so structure factors are evaluated on demand
             if(c.geometryChange) {
-              updateAllComplexNumbers(spc->trial, Q_ion_tot_trial, Q_dip_tot_trial,kVectors_trial,kVectorsInUse_trial);
               V_trial = V + c.dV;
-	      parameters.update(spc->geo_trial.len);
+              stale = true;
               return 0.0;
             }
 
-            // If the volume has not changed
-            for (int k=0; k<kVectorsInUse_trial; k++) {
-              complex<double> Q2_ion = Q_ion_tot.at(k);
-              complex<double> Q2_dip = Q_dip_tot.at(k);
-              for (auto m : change.mvGroup) {
-                for (auto i : m.second) {
-                  double dotTrial = kVectors_trial.col(k).dot(spc->trial[i]);
-                  double dot = kVectors.col(k).dot(spc->p[i]);
-                  if ( ( useIonIon || useIonDipole ) && !isotropic_pbc ) {
-                    Q2_ion += spc->trial[i].charge * complex<double>(cos(dotTrial),sin(dotTrial));
-                    Q2_ion -= spc->p[i].charge * complex<double>(cos(dot),sin(dot));
-                  } else if( ( useIonIon || useIonDipole ) && isotropic_pbc ) {
-		    Point kv = kVectors_trial.col(k);
-		    Q2_ion += spc->trial[i].charge*cos(kv.x()*spc->trial[i].x())*cos(kv.y()*spc->trial[i].y())*cos(kv.z()*spc->trial[i].z()); 
-		    kv = kVectors.col(k);
-		    Q2_ion -= spc->p[i].charge*cos(kv.x()*spc->p[i].x())*cos(kv.y()*spc->p[i].y())*cos(kv.z()*spc->p[i].z()); 
-		  }
-                  if ( ( useDipoleDipole || useIonDipole ) && !isotropic_pbc ) {
-                    Q2_dip += kVectors_trial.col(k).dot(spc->trial[i].mu()) * spc->trial[i].muscalar() * complex<double>(-sin(dotTrial),cos(dotTrial));
-                    Q2_dip -= kVectors.col(k).dot(spc->p[i].mu()) * spc->p[i].muscalar() * complex<double>(-sin(dot),cos(dot));
-                  } else if ( ( useDipoleDipole || useIonDipole ) && isotropic_pbc ) {
-		    Point kv = kVectors_trial.col(k);
-		    double xx = spc->trial[i].x()*kv.x();
-		    double yy = spc->trial[i].y()*kv.y();
-		    double zz = spc->trial[i].z()*kv.z();
-		    double cosX = cos(xx);
-		    double cosY = cos(yy);
-		    double cosZ = cos(zz);
-		    Q2_dip += ( sin(xx)*cosY*cosZ*spc->trial[i].mu().x()*kv.x() + cosX*sin(yy)*cosZ*spc->trial[i].mu().y()*kv.y() + cosX*cosY*sin(zz)*spc->trial[i].mu().z()*kv.z() )*spc->trial[i].muscalar();
-		    kv = kVectors.col(k);
-		    xx = spc->p[i].x()*kv.x();
-		    yy = spc->p[i].y()*kv.y();
-		    zz = spc->p[i].z()*kv.z();
-		    cosX = cos(xx);
-		    cosY = cos(yy);
-		    cosZ = cos(zz);
-		    Q2_dip -= ( sin(xx)*cosY*cosZ*spc->p[i].mu().x()*kv.x() + cosX*sin(yy)*cosZ*spc->p[i].mu().y()*kv.y() + cosX*cosY*sin(zz)*spc->p[i].mu().z()*kv.z() )*spc->p[i].muscalar();
-                  }
-                }
-              }
-              Q_ion_tot_trial.at(k) = Q2_ion;
-              Q_dip_tot_trial.at(k) = Q2_dip;
+            // If the volume has not changed only moved particles contribute to the difference
+            V_trial = V;
+            Q_ion_tot_trial = Q_ion_tot;
+            Q_dip_tot_trial = Q_dip_tot;
+            for (auto &m : change.mvGroup) {
+              auto add = [&](int i) {
+                addComplexNumbers(spc->trial[i], 1.0, Q_ion_tot_trial, Q_dip_tot_trial, kVectors, kIndex, kUnit, kVectorsInUse);
+                addComplexNumbers(spc->p[i], -1.0, Q_ion_tot_trial, Q_dip_tot_trial, kVectors, kIndex, kUnit, kVectorsInUse);
+              };
+              if (m.second.empty()) // all particles in group have moved
+                for (auto i : *spc->groupList().at(m.first))
+                  add(i);
+              else
+                for (auto i : m.second)
+                  add(i);
             }
             return 0.0;
           }
@@ -646,49 +711,530 @@ namespace Faunus {
 	    return getSelfEnergy(p,g,parameters);
           }
 
+          /** @brief Sets and returns the reciprocal energy of the trial structure factors */
+          double trialReciprocalEnergy() {
+            if (stale)
+              scaledComplexNumbers();
+            if (!pending) // no change; trial structure factors equal the accepted ones
+              reciprocalEnergyTrial = getReciprocalEnergy(Q_ion_tot,Q_dip_tot,Aks,V_trial);
+            else if (trialGeometry)
+              reciprocalEnergyTrial = getReciprocalEnergy(Q_ion_tot_trial,Q_dip_tot_trial,Aks_trial,V_trial);
+            else
+              reciprocalEnergyTrial = getReciprocalEnergy(Q_ion_tot_trial,Q_dip_tot_trial,Aks,V_trial);
+            return reciprocalEnergyTrial;
+          }
+
           double external(const Tpvec &p) override {
             Group g(0, p.size()-1);
 	    double total = 0.0;
             if (Tbase::isTrial(p)) {
-              surfaceEnergyTrial = getSurfaceEnergy(p,g,V_trial);
-              reciprocalEnergyTrial = getReciprocalEnergy(Q_ion_tot_trial,Q_dip_tot_trial,Aks_trial,V_trial);
-	      total = surfaceEnergyTrial + reciprocalEnergyTrial;
+              qrs_trial = mus_trial = Point(0,0,0);
+              addDipoleMoment(p, g, qrs_trial, mus_trial);
+              trialMoments = true;
+              surfaceEnergyTrial = getSurfaceEnergy(qrs_trial,mus_trial,V_trial);
+	      total = surfaceEnergyTrial + trialReciprocalEnergy();
             } else {
-              surfaceEnergy = getSurfaceEnergy(p,g,V);
+              qrs = mus = Point(0,0,0);
+              addDipoleMoment(p, g, qrs, mus);
+              surfaceEnergy = getSurfaceEnergy(qrs,mus,V);
               reciprocalEnergy = getReciprocalEnergy(Q_ion_tot,Q_dip_tot,Aks,V);
 	      total = surfaceEnergy + reciprocalEnergy;
             }
             return total;
           }
+
+          /**
+           * @brief Change in surface and reciprocal energy
+           *
+           * The surface term is updated from the moved particles only and the
+           * accepted energies are taken from the last evaluation, so no loop
+           * over all particles is needed. Volume moves, insertions and
+           * deletions fall back to `external()`.
+           */
+          double externalChange(const typename Tspace::Change &c) override {
+            if (c.geometryChange || !c.rmGroup.empty() || !c.inGroup.empty())
+              return Tbase::externalChange(c);
+            qrs_trial = qrs;
+            mus_trial = mus;
+            for (auto &m : c.mvGroup) {
+              if (m.second.empty()) {
+                auto &g = *spc->groupList().at(m.first);
+                addDipoleMoment(spc->trial, g, qrs_trial, mus_trial);
+                addDipoleMoment(spc->p, g, qrs_trial, mus_trial, -1.0);
+              } else {
+                addDipoleMoment(spc->trial, m.second, qrs_trial, mus_trial);
+                addDipoleMoment(spc->p, m.second, qrs_trial, mus_trial, -1.0);
+              }
+            }
+            trialMoments = true;
+            surfaceEnergyTrial = getSurfaceEnergy(qrs_trial,mus_trial,V_trial);
+            return surfaceEnergyTrial + trialReciprocalEnergy() - (surfaceEnergy + reciprocalEnergy);
+          }
     
+          /**
+           * @brief Sets the geometry and rescales k-vectors if the box has changed
+           *
+           * During a pending geometry change, i.e. between `updateChange()` and `update()`, any
+           * box differing from the accepted one is taken to be the trial box. Otherwise the
+           * k-vectors are rescaled and all structure factors are recalculated.
+           */
           void setGeometry(typename Tspace::GeometryType &g) override {
             Tbase::setGeometry(g);
 	    parameters.update(g.len);
-	    if(Tbase::isGeometryTrial(g)) {
+	    if(Tbase::isGeometryTrial(g) || (pending && change.geometryChange)) {
+              if ((g.len - len).squaredNorm() < 1e-20) // accepted box (restored)
+                return;
+              if (trialGeometry && (g.len - len_trial).squaredNorm() < 1e-20)
+                return;
 	      V_trial = g.getVolume();
-	      kVectorChange(kVectors_trial,Aks_trial,Q_ion_tot_trial,Q_dip_tot_trial,kVectorsInUse_trial,parameters);
-	      updateAllComplexNumbers(spc->trial,Q_ion_tot_trial,Q_dip_tot_trial,kVectors_trial,kVectorsInUse_trial);
+              len_trial = g.len;
+	      kVectorScale(len_trial, kVectors_trial, kUnit_trial, Aks_trial);
+              pending = trialGeometry = stale = true;
 	    } else {
 	      V = g.getVolume();
-	      kVectorChange(kVectors,Aks,Q_ion_tot,Q_dip_tot,kVectorsInUse,parameters);
-	      updateAllComplexNumbers(spc->p,Q_ion_tot,Q_dip_tot,kVectors,kVectorsInUse);
+              len = g.len;
+	      kVectorScale(len, kVectors, kUnit, Aks);
+	      updateAllComplexNumbers(spc->p,Q_ion_tot,Q_dip_tot,kVectors,kIndex,kUnit,kVectorsInUse);
 	    }
 	  }
 	  
+          /** @brief Discards trial entities and recalculates k-vectors and structure factors from `Space::p` */
+          void refresh() override {
+            Tbase::refresh();
+            change.clear();
+            undo();
+            cnt_accepted = 0;
+            setGeometry(spc->geo);
+          }
+
           /**
            * @brief Set space and updates parameters (if not set by user)
+           *
+           * Trial entities are kept if a geometry change is pending as volume moves
+           * set the space for both the trial and the restored or accepted box.
            */
           void setSpace(Tspace &s) override {
             Tbase::setSpace(s);
             N = s.p.size();
+            if (update_frequency < 1)
+              update_frequency = std::max(N, 1);
+            if (pending && change.geometryChange)
+              return;
 	    Group g(0, N-1);
-	    surfaceEnergy = getSurfaceEnergy(s.p,g,V);
+            qrs = mus = Point(0,0,0);
+            addDipoleMoment(s.p, g, qrs, mus);
+	    surfaceEnergy = getSurfaceEnergy(qrs,mus,V);
 	    reciprocalEnergy = getReciprocalEnergy(Q_ion_tot,Q_dip_tot,Aks,V);
 	    undo(); // initialization of trial-entities
-            //change.clear();
           }
       };
 
+
+    /**
+     * @brief Smooth particle mesh Ewald (SPME) for ion-ion interactions
+     * @date Lund 2016
+     *
+     * The reciprocal part of the Ewald sum is evaluated by spreading charges onto a
+     * regular 3D mesh using cardinal B-splines of order \f$ n \f$ and solving Poisson's
+     * equation with fast Fourier transforms (DOI: 10.1063/1.470117),
+     *
+     * @f[
+     * E_{Reciprocal} = \frac{1}{2\pi V}\sum_{{\bf m}\ne {\bf 0}} \frac{e^{-\pi^2 m^2/\alpha^2}}{m^2} B({\bf m}) \left|\mathcal{F}(Q)({\bf m})\right|^2
+     * = \frac{1}{2} \sum_{\bf x} Q({\bf x})\phi({\bf x})
+     * @f]
+     *
+     * where \f$ \phi=\theta\star Q \f$ is the mesh potential. A full evaluation scales as
+     * \f$ \mathcal{O}(N + K^3\log K^3) \f$ rather than \f$ \mathcal{O}(N K) \f$ for `NonbondedEwald`.
+     *
+     * Moving a few particles changes only the \f$ n^3 \f$ mesh points of their old and
+     * new stencils, \f$ \delta Q \f$, and the energy change is evaluated in real space,
+     *
+     * @f[
+     * \Delta E = \sum_{\bf x} \delta Q({\bf x})\phi({\bf x}) + \frac{1}{2}\sum_{{\bf x},{\bf y}} \delta Q({\bf x})\theta({\bf x}-{\bf y})\delta Q({\bf y})
+     * @f]
+     *
+     * Accepted changes are accumulated and the mesh potential is refreshed by FFT only
+     * when the accumulated stencils make the real space correction more expensive than
+     * a transform. Trial moves touching many mesh points, as well as volume moves,
+     * re-grid the trial configuration in full. Tinfoil boundary conditions are assumed.
+     *
+     * Options are read from the same section as `NonbondedEwald`:
+     *
+     *  Keyword          |  Description
+     * :--------------   | :---------------
+     * `alpha`           |  Damping parameter
+     * `cutoff`          |  Real space cut-off
+     * `mesh`            |  Number of mesh points in each dimension (Default: 32)
+     * `spline_order`    |  Order of the B-splines, \f$ n\ge 3 \f$ (Default: 4)
+     *
+     * Fourier transforms are handled by Eigen's FFT module which allows any mesh size,
+     * although products of small primes are the most efficient.
+     */
+    template<class Tspace, class Tpairpot,
+      class Tbase=NonbondedVector<Tspace, CombinedPairPotential<EwaldReal<true,false,false>, Tpairpot>>>
+      class NonbondedPME : public Tbase {
+        private:
+          using Tbase::spc;
+          typedef typename Tbase::Tparticle Tparticle;
+          typedef typename Tbase::Tpvec Tpvec;
+          typedef vector<complex<double>> Tcvec;
+
+          /** @brief Mesh, influence function and energy for one geometry */
+          struct Grid {
+            Point len = Point(0,0,0);
+            vector<double> G;     // influence function in reciprocal space
+            vector<double> theta; // influence function in real space
+            vector<double> Q;     // charge mesh
+            vector<double> phi;   // theta*Q at the last refresh
+            vector<double> dQ;    // charge spread since the last refresh
+            vector<int> touched;  // elements in dQ changed since the last refresh
+            vector<char> isTouched;
+            double energy = 0;
+          };
+
+          /** @brief B-spline stencil of a single particle */
+          struct Stencil {
+            int first[3];
+            vector<double> w[3];
+          };
+
+          enum Trialmode {NONE, SPARSE, FULL, REGRID};
+
+          Grid grid, gridTrial;
+          Trialmode mode;
+          int K, order, M, cntRefresh;
+          double alpha, lB, fftCost;
+          vector<double> bmod, delta; // B-spline moduli; trial charge changes
+          vector<int> deltaList;      // elements in delta changed by the trial move
+          vector<char> inDelta;
+          double deltaEnergy;
+          Stencil stencil;
+          Eigen::FFT<double> fft;
+
+          /** @brief Cardinal B-spline weights, w[j]=M_n(u+n-1-j), for fractional coordinate u */
+          void bspline(double u, vector<double> &w) const {
+            w.assign(order, 0.0);
+            w[0] = 1 - u;
+            w[1] = u;
+            for (int j = 3; j <= order; j++) {
+              double div = 1.0/(j-1);
+              w[j-1] = div*u*w[j-2];
+              for (int k = 1; k < j-1; k++)
+                w[j-k-1] = div*((u+k)*w[j-k-2] + (j-k-u)*w[j-k-1]);
+              w[0] = div*(1-u)*w[0];
+            }
+          }
+
+          /** @brief Squared moduli of the B-spline structure factor, |b(m)|^-2 */
+          void splineModuli() {
+            vector<double> w;
+            bspline(0.0, w);
+            bmod.resize(K);
+            for (int m = 0; m < K; m++) {
+              complex<double> s = 0;
+              for (int k = 0; k < order-1; k++)
+                s += w[order-2-k] * std::polar(1.0, 2*pc::pi*m*k/K);
+              bmod[m] = std::norm(s);
+            }
+          }
+
+          /** @brief Mesh stencil for a position in a box with side lengths `len` */
+          void setStencil(const Point &a, const Point &len, Stencil &s) const {
+            for (int d = 0; d < 3; d++) {
+              double u = K * (a[d]/len[d] + 0.5);
+              double fl = std::floor(u);
+              bspline(u - fl, s.w[d]);
+              s.first[d] = int(fl) - order + 1;
+            }
+          }
+
+          inline int wrap(int i) const { return (i % K + K) % K; }
+
+          inline int index(int i, int j, int k) const { return (wrap(i)*K + wrap(j))*K + wrap(k); }
+
+          /** @brief Index of the mesh point at the periodic difference between mesh points `a` and `b` */
+          inline int difference(int a, int b) const {
+            return index(a/(K*K) - b/(K*K), (a/K)%K - (b/K)%K, a%K - b%K);
+          }
+
+          /**
+           * @brief Spreads `sign` times the charge of `a` onto `mesh`
+           *
+           * If given, mesh points not yet flagged in `flag` are flagged and appended to `list`.
+           */
+          void spread(const Tparticle &a, const Point &len, double sign, vector<double> &mesh,
+              vector<int> *list=nullptr, vector<char> *flag=nullptr) {
+            if (std::fabs(a.charge) < 1e-12)
+              return;
+            setStencil(a, len, stencil);
+            for (int i = 0; i < order; i++)
+              for (int j = 0; j < order; j++) {
+                double wxy = sign * a.charge * stencil.w[0][i] * stencil.w[1][j];
+                for (int k = 0; k < order; k++) {
+                  int n = index(stencil.first[0]+i, stencil.first[1]+j, stencil.first[2]+k);
+                  if (list != nullptr && !(*flag)[n]) {
+                    (*flag)[n] = 1;
+                    list->push_back(n);
+                  }
+                  mesh[n] += wxy * stencil.w[2][k];
+                }
+              }
+          }
+
+          /** @brief In-place 3D transform from successive 1D transforms along each axis */
+          void fft3(Tcvec &a, bool inverse) {
+            Tcvec in(K), out(K);
+            int stride[3] = {K*K, K, 1};
+            for (int d = 0; d < 3; d++)
+              for (int n = 0; n < M; n++) {
+                if ((n / stride[d]) % K != 0)
+                  continue;
+                for (int i = 0; i < K; i++)
+                  in[i] = a[n + i*stride[d]];
+                if (inverse)
+                  fft.inv(out, in);
+                else
+                  fft.fwd(out, in);
+                for (int i = 0; i < K; i++)
+                  a[n + i*stride[d]] = out[i];
+              }
+          }
+
+          /** @brief Influence function of the mesh for box side lengths `len` */
+          void setInfluence(Grid &g, const Point &len) {
+            g.len = len;
+            g.G.assign(M, 0.0);
+            double V = len.x()*len.y()*len.z();
+            double pre = M * lB / (pc::pi * V);
+            for (int i = 0; i < K; i++)
+              for (int j = 0; j < K; j++)
+                for (int k = 0; k < K; k++) {
+                  Point m( (i <= K/2 ? i : i-K) / len.x(),
+                      (j <= K/2 ? j : j-K) / len.y(),
+                      (k <= K/2 ? k : k-K) / len.z() );
+                  double m2 = m.squaredNorm(), b = bmod[i]*bmod[j]*bmod[k];
+                  if (m2 > 0 && b > 1e-10)
+                    g.G[(i*K + j)*K + k] = pre * exp(-pc::pi*pc::pi*m2/(alpha*alpha)) / (m2 * b);
+                }
+            Tcvec a(g.G.begin(), g.G.end());
+            fft3(a, true);
+            g.theta.resize(M);
+            for (int n = 0; n < M; n++)
+              g.theta[n] = a[n].real();
+          }
+
+          /** @brief Mesh potential and energy by FFT; clears accumulated changes */
+          void refresh(Grid &g) {
+            Tcvec a(g.Q.begin(), g.Q.end());
+            fft3(a, false);
+            for (int n = 0; n < M; n++)
+              a[n] *= g.G[n];
+            fft3(a, true);
+            g.phi.resize(M);
+            g.energy = 0;
+            for (int n = 0; n < M; n++) {
+              g.phi[n] = a[n].real();
+              g.energy += 0.5 * g.Q[n] * g.phi[n];
+            }
+            g.dQ.assign(M, 0.0);
+            g.isTouched.assign(M, 0);
+            g.touched.clear();
+            cntRefresh++;
+          }
+
+          /** @brief Spreads all particles onto the mesh of a box with side lengths `len` */
+          void regrid(Grid &g, const Tpvec &p, const Point &len) {
+            if ((g.len - len).squaredNorm() > 1e-12 || int(g.G.size()) != M)
+              setInfluence(g, len);
+            g.Q.assign(M, 0.0);
+            for (auto &a : p)
+              spread(a, len, 1.0, g.Q);
+            refresh(g);
+          }
+
+          /** @brief Mesh potential at point `n` including charges spread since the last refresh */
+          double potential(const Grid &g, int n) const {
+            double phi = g.phi[n];
+            for (int m : g.touched)
+              phi += g.theta[difference(n, m)] * g.dQ[m];
+            return phi;
+          }
+
+          /** @brief Energy change due to the sparse charge change in `delta` */
+          double sparseEnergy() const {
+            double du = 0;
+            for (size_t i = 0; i < deltaList.size(); i++) {
+              int n = deltaList[i];
+              double pair = 0.5 * grid.theta[0] * delta[n];
+              for (size_t j = i+1; j < deltaList.size(); j++)
+                pair += grid.theta[difference(n, deltaList[j])] * delta[deltaList[j]];
+              du += delta[n] * (potential(grid, n) + pair);
+            }
+            return du;
+          }
+
+          void clearDelta() {
+            for (int n : deltaList)
+              delta[n] = inDelta[n] = 0;
+            deltaList.clear();
+          }
+
+          /** @brief Accumulates the accepted sparse change; refreshes by FFT when that becomes cheaper */
+          void acceptSparse() {
+            for (int n : deltaList) {
+              if (!grid.isTouched[n]) {
+                grid.isTouched[n] = 1;
+                grid.touched.push_back(n);
+              }
+              grid.dQ[n] += delta[n];
+              grid.Q[n] += delta[n];
+            }
+            grid.energy += deltaEnergy;
+            if (double(grid.touched.size()) * 2 * order*order*order > fftCost)
+              refresh(grid);
+          }
+
+          string _info() override {
+            using namespace Faunus::textio;
+            char w=25;
+            std::ostringstream o;
+            o << Tbase::_info();
+            o << header("Particle mesh Ewald");
+            o << pad(SUB,w, "Mesh") << K << "x" << K << "x" << K << endl;
+            o << pad(SUB,w, "Spline order") << order << endl;
+            o << pad(SUB,w, "alpha") << alpha << endl;
+            o << pad(SUB,w, "Real cut-off") << Tbase::pairpot.first.rc << endl;
+            o << pad(SUB,w, "FFT refreshes") << cntRefresh << endl;
+            o << pad(SUB,w+4, bracket("Reci energy")) << reciprocalEnergyAverage.avg() << kT << endl;
+            return o.str();
+          }
+
+        public:
+          MeanValue<double> reciprocalEnergyAverage;
+
+          NonbondedPME(Tmjson &j, const string &sec="nonbonded") : Tbase(j,sec),
+              reciprocalEnergyAverage(j["energy"]["nonbonded"]["avg_block"] | 100) {
+            Tbase::name += " (PME)";
+            auto _j = j["energy"]["nonbonded"]["ewald"];
+            alpha = _j.at("alpha");
+            K = _j.value("mesh", 32);
+            order = _j.value("spline_order", 4);
+            if (order < 3)
+              throw std::runtime_error("PME spline order must be three or higher");
+            if (K < order)
+              throw std::runtime_error("PME mesh must be larger than the spline order");
+            M = K*K*K;
+            fftCost = 2 * M * std::log2(double(M));
+            lB = Tbase::pairpot.first.bjerrumLength();
+            Tbase::pairpot.first.updateRcut(_j.at("cutoff"));
+            Tbase::pairpot.first.updateAlpha(alpha);
+            for (auto &w : stencil.w)
+              w.resize(order);
+            splineModuli();
+            delta.assign(M, 0.0);
+            inDelta.assign(M, 0);
+            mode = NONE;
+            cntRefresh = 0;
+          }
+
+          /** @brief Reciprocal space energy of the accepted configuration (kT) */
+          double reciprocalEnergy() const { return grid.energy; }
+
+          /** @brief Number of full mesh potential evaluations by FFT */
+          int numRefresh() const { return cntRefresh; }
+
+          /**
+           * @brief Prepares the trial mesh for a change
+           *
+           * Moved particles are re-spread onto a sparse copy of the mesh. Volume and
+           * particle number changes are re-gridded when the trial energy is requested
+           * as the trial box length may not yet be known.
+           */
+          double updateChange(const typename Tspace::Change &c) override {
+            clearDelta();
+            deltaEnergy = 0;
+            mode = NONE;
+            if (c.empty() || c.geometryChange || !c.rmGroup.empty() || !c.inGroup.empty()) {
+              mode = REGRID;
+              return 0.0;
+            }
+            for (auto &m : c.mvGroup) {
+              auto add = [&](int i) {
+                spread(spc->trial[i], grid.len, 1.0, delta, &deltaList, &inDelta);
+                spread(spc->p[i], grid.len, -1.0, delta, &deltaList, &inDelta);
+              };
+              if (m.second.empty()) // all particles in group have moved
+                for (auto i : *spc->groupList().at(m.first))
+                  add(i);
+              else
+                for (auto i : m.second)
+                  add(i);
+            }
+            double n = deltaList.size();
+            if (n * (n + grid.touched.size()) < fftCost) {
+              deltaEnergy = sparseEnergy();
+              mode = SPARSE;
+            } else {
+              gridTrial = grid;
+              for (int i : deltaList)
+                gridTrial.Q[i] += delta[i];
+              refresh(gridTrial);
+              mode = FULL;
+            }
+            return 0.0;
+          }
+
+          double update(bool move_accepted) override {
+            if (move_accepted) {
+              if (mode == SPARSE)
+                acceptSparse();
+              else if (mode == FULL)
+                std::swap(grid, gridTrial);
+              else if (mode == REGRID) // trial energy never evaluated
+                regrid(grid, spc->p, spc->geo.len);
+            }
+            clearDelta();
+            mode = NONE;
+            reciprocalEnergyAverage += grid.energy;
+            return 0.0;
+          }
+
+          double i_external(const Tpvec &p, int i) override {
+            Group g = Group(i,i);
+            return g_external(p,g);
+          }
+
+          /** @brief Ewald self energy (kT) */
+          double g_external(const Tpvec &p, Group &g) override {
+            double q2 = 0;
+            for (auto i : g)
+              q2 += p[i].charge * p[i].charge;
+            return -alpha * q2 / sqrt(pc::pi) * lB;
+          }
+
+          /** @brief Reciprocal space energy (kT) */
+          double external(const Tpvec &p) override {
+            if (Tbase::isTrial(p)) {
+              if (mode == REGRID) {
+                regrid(gridTrial, p, spc->geo.len);
+                mode = FULL;
+              }
+              if (mode == FULL)
+                return gridTrial.energy;
+              if (mode == SPARSE)
+                return grid.energy + deltaEnergy;
+            } else if (mode == NONE && (grid.len - spc->geo.len).squaredNorm() > 1e-12)
+              regrid(grid, p, spc->geo.len);
+            return grid.energy;
+          }
+
+          /** @brief Set space and re-grid unless a trial move is pending */
+          void setSpace(Tspace &s) override {
+            Tbase::setSpace(s);
+            if (mode == NONE)
+              regrid(grid, s.p, s.geo.len);
+          }
+      };
   }//namespace
 }//namespace
 #endif
@@ -703,6 +703,109 @@ namespace Faunus
         }
     };
 
+    /**
+     * @brief Linked-cell spatial index for cuboidal containers
+     *
+     * The container is divided into a regular grid of cells with side lengths
+     * no smaller than the cutoff so that all particles within the cutoff of a
+     * point are found in its own cell or in one of the (at most 26) neighbouring
+     * cells. Periodicity is deduced from the geometry type: `Cuboidslit` is not
+     * periodic in z and `CuboidNoPBC` is not periodic in any direction.
+     *
+     * Example:
+     *
+     *     Geometry::CellList cells;
+     *     cells.setGeometry( spc.geo, 12.0 ); // cutoff = 12 angstrom
+     *     cells.build( spc.p );
+     *     cells.forNeighbours( spc.p[0], [&](int j) { ... } );
+     *     cells.update( 5, spc.p[5] );        // particle 5 was displaced
+     *
+     * @note Particles are assigned to cells using the coordinates passed to
+     *       `build()` and `update()`; the owner is responsible for keeping
+     *       these in sync with the particle vector.
+     */
+    class CellList
+    {
+    private:
+        Eigen::Vector3i n;                        // number of cells in each direction
+        Point len_half;                           // half container side lengths
+        Point cellinv;                            // inverse cell side lengths
+        std::vector<std::vector<int>> cells;      // particle index in each cell
+        std::vector<std::vector<int>> neighbours; // neighbouring cells incl. self (no duplicates)
+        std::vector<int> cellOf;                  // cell index of each particle
+        std::vector<int> slot;                    // position of each particle in its cell
+        double rc;                                // cutoff (angstrom)
+
+        void setup( const Point &, double, const std::array<bool, 3> & );
+        void add( int, int );
+        void remove( int );
+
+    public:
+        CellList();
+
+        /**
+         * @brief Set grid from geometry and cutoff. This clears all particles.
+         * @param geo Cuboid geometry or derived hereof
+         * @param cutoff Minimum cell side length (angstrom)
+         */
+        template<class Tgeometry>
+        void setGeometry( const Tgeometry &geo, double cutoff )
+        {
+            static_assert(std::is_base_of<Cuboid, Tgeometry>::value,
+                          "Cell lists require a cuboidal geometry");
+            bool xy = !std::is_base_of<CuboidNoPBC, Tgeometry>::value;
+            bool z = xy && !std::is_base_of<Cuboidslit, Tgeometry>::value;
+            setup(geo.len, cutoff, {{xy, xy, z}});
+        }
+
+        /** @brief Cell index of a point */
+        inline int index( const Point &a ) const
+        {
+            int c[3];
+            for ( int d = 0; d < 3; d++ )
+                c[d] = std::min(std::max(int((a[d] + len_half[d]) * cellinv[d]), 0), n[d] - 1);
+            return c[0] + n[0] * (c[1] + n[1] * c[2]);
+        }
+
+        /** @brief Assign all particles in vector to cells */
+        template<class Tpvec>
+        void build( const Tpvec &p )
+        {
+            for ( auto &c : cells )
+                c.clear();
+            cellOf.resize(p.size());
+            slot.resize(p.size());
+            for ( size_t i = 0; i < p.size(); i++ )
+                add(i, index(p[i]));
+        }
+
+        void update( int, const Point & );    //!< Re-assign i'th particle to cell matching new position
+        void clear();                         //!< Remove all particles (grid is kept)
+
+        size_t size() const { return cellOf.size(); }    //!< Number of indexed particles
+        size_t numCells() const { return cells.size(); } //!< Number of cells
+        double cutoff() const { return rc; }             //!< Cutoff used for cell sizes
+        Eigen::Vector3i gridSize() const { return n; }   //!< Number of cells in each direction
+
+        /** @brief Average number of particles found in a neighbour search */
+        double averageNeighbours() const;
+
+        /**
+         * @brief Call function for all particle indices in the cell of `a` and its neighbours
+         *
+         * The function is called with the particle index as argument. All
+         * particles within the cutoff are visited, but so are particles further
+         * away and it is up to the caller to discard these.
+         */
+        template<class Tfunction>
+        void forNeighbours( const Point &a, Tfunction f ) const
+        {
+            for ( auto c : neighbours[index(a)] )
+                for ( auto j : cells[c] )
+                    f(j);
+        }
+    };
+
     /**
      * @brief Calculates the volume of a collection of particles
      *
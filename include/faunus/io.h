@@ -5,6 +5,10 @@
 #include <faunus/common.h>
 #include <faunus/geometry.h>
 #include <faunus/group.h>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #ifndef __cplusplus
 #define __cplusplus
@@ -668,6 +672,7 @@ namespace Faunus {
       XDRFILE *xd;        //!< file handle
       matrix xdbox;       //!< box dimensions
       rvec *x_xtc;        //!< vector of particle coordinates
+      std::vector<float> xbuf; //!< reused output coordinates (3N, nm)
       float time_xtc, prec_xtc;
       int natoms_xtc, step_xtc;
     public:
@@ -747,7 +752,8 @@ namespace Faunus {
           if ( xd == NULL )
             xd = xdrfile_open(&file[0], "w");
           if ( xd != NULL ) {
-            rvec *x = new rvec[N];
+            xbuf.resize( 3*N );
+            rvec *x = reinterpret_cast<rvec*>( xbuf.data() );
             unsigned int i=0;
             for ( auto j : g ) {
               assert( i>=0 && i<p.size() && "Index out of range" );
@@ -758,7 +764,6 @@ namespace Faunus {
               i++;
             }
             write_xtc( xd, N, step_xtc++, time_xtc++, xdbox, x, prec_xtc );
-            delete[] x;
             return true;
           }
           return false;
@@ -818,6 +823,169 @@ namespace Faunus {
 
   };
 
+  /**
+   * @brief Write XTC trajectory in a background thread
+   *
+   * Same output as `FormatXTC::save()`, but the calling thread only
+   * copies coordinates into a recycled frame buffer; XDR compression
+   * and file output are done by a writer thread. If more than `maxqueue`
+   * frames are pending, `save()` blocks until the writer catches up.
+   * The default, `maxqueue=1`, is plain double buffering: one frame is
+   * filled while the previous is written. With `maxqueue=0` the queue
+   * is unbounded and buffers are only allocated when all existing
+   * ones are in use. Pending frames are written when calling `close()`
+   * or on destruction.
+   *
+   * Example:
+   *
+   * ~~~{.cpp}
+   * FormatXTCAsync xtc(1000);
+   * xtc.setbox( spc.geo.inscribe().len );
+   * xtc.save( "traj.xtc", spc.p );
+   * ~~~
+   */
+  class FormatXTCAsync {
+    private:
+      struct Frame {
+        std::vector<float> x; // coordinates (3N, nm)
+        matrix box;
+        int step;
+        float time;
+      };
+
+      XDRFILE *xd;            //!< file handle
+      matrix xdbox;           //!< box dimensions
+      float time_xtc, prec_xtc;
+      int step_xtc;
+      size_t maxqueue;        //!< max. pending frames (0=unbounded)
+      bool stop, busy, failed;
+      std::deque<Frame> queue;  //!< frames waiting to be written
+      std::vector<Frame> pool;  //!< recycled frame buffers
+      std::mutex mtx;
+      std::condition_variable notEmpty, notFull, idle;
+      std::thread writer;
+
+      void writeLoop() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while ( true ) {
+          notEmpty.wait( lock, [this]{ return stop || !queue.empty(); } );
+          if ( queue.empty() )
+            return;
+          Frame f = std::move( queue.front() );
+          queue.pop_front();
+          busy = true;
+          notFull.notify_one();
+          lock.unlock();
+          int rc = write_xtc( xd, int(f.x.size()/3), f.step, f.time, f.box,
+              reinterpret_cast<rvec*>( f.x.data() ), prec_xtc );
+          lock.lock();
+          busy = false;
+          if ( rc != exdrOK )
+            failed = true;
+          pool.push_back( std::move(f) );
+          idle.notify_all();
+        }
+      }
+
+    public:
+
+      FormatXTCAsync( double len, size_t maxqueue=1 ) : xd(NULL), time_xtc(0), prec_xtc(1000.),
+      step_xtc(0), maxqueue(maxqueue), stop(false), busy(false), failed(false) {
+        setbox(len);
+        pool.resize( maxqueue + 1 );
+      }
+
+      ~FormatXTCAsync() { close(); }
+
+      /**
+       * @brief Queue frame for writing
+       *
+       * Opens `file` on the first call. Returns false if the file
+       * cannot be opened or if a previous frame failed to be written.
+       */
+      template<class Tpoint, class Talloc, class Tgroup=Group>
+        bool save(const string &file, const std::vector<Tpoint,Talloc> &p, Tgroup g = Group() ) {
+          if ( g.empty() )
+            g.resize( p.size() );
+          size_t N = g.size();
+          assert( N > 0 );
+          if ( xd == NULL ) {
+            xd = xdrfile_open(&file[0], "w");
+            if ( xd == NULL )
+              return false;
+            stop = false;
+            writer = std::thread( &FormatXTCAsync::writeLoop, this );
+          }
+          Frame f;
+          {
+            std::unique_lock<std::mutex> lock(mtx);
+            if ( maxqueue > 0 )
+              notFull.wait( lock, [this]{ return queue.size() < maxqueue; } );
+            if ( failed )
+              return false;
+            if ( !pool.empty() ) {
+              f = std::move( pool.back() );
+              pool.pop_back();
+            }
+          }
+          f.x.resize( 3*N );
+          rvec *x = reinterpret_cast<rvec*>( f.x.data() );
+          unsigned int i=0;
+          for ( auto j : g ) {
+            x[i][0] = p.at(j).x()*0.1 + xdbox[0][0]*0.5; // AA->nm
+            x[i][1] = p.at(j).y()*0.1 + xdbox[1][1]*0.5; // move inside sim. box
+            x[i][2] = p.at(j).z()*0.1 + xdbox[2][2]*0.5; //
+            i++;
+          }
+          for (int k=0; k<3; k++)
+            for (int l=0; l<3; l++)
+              f.box[k][l] = xdbox[k][l];
+          f.step = step_xtc++;
+          f.time = time_xtc++;
+          {
+            std::lock_guard<std::mutex> lock(mtx);
+            queue.push_back( std::move(f) );
+          }
+          notEmpty.notify_one();
+          return true;
+        }
+
+      /** @brief Block until all queued frames are written */
+      inline void flush() {
+        std::unique_lock<std::mutex> lock(mtx);
+        idle.wait( lock, [this]{ return queue.empty() && !busy; } );
+      }
+
+      /** @brief Write pending frames and close file */
+      inline void close() {
+        if ( writer.joinable() ) {
+          {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+          }
+          notEmpty.notify_one();
+          writer.join();
+        }
+        if ( xd != NULL )
+          xdrfile_close(xd);
+        xd = NULL;
+      }
+
+      inline void setbox(double x, double y, double z) {
+        assert(x>0 && y>0 && z>0);
+        for (int i=0; i<3; i++)
+          for (int j=0; j<3; j++)
+            xdbox[i][j]=0;
+        xdbox[0][0]=0.1*x; // corners of the
+        xdbox[1][1]=0.1*y; // rectangular box
+        xdbox[2][2]=0.1*z; // in nanometers!
+      }
+
+      inline void setbox(double len) { setbox(len,len,len); }
+
+      inline void setbox(const Point &p) { setbox(p.x(), p.y(), p.z()); }
+  };
+
   class FormatTopology {
     private:
       int rescnt;
@@ -146,6 +146,8 @@ namespace Faunus
                     Point mu_trial = p[i].alpha() * E + p[i].mup();// new tot. dipole
                     Point mu_err = mu_trial - p[i].mu() * p[i].muscalar();// mu difference
                     mu_err_norm[i] = mu_err.norm();          // norm of previous row
+                    if ( mu_err_norm[i] > 0 )
+                        spc->touch(i);                       // dipole changed
                     p[i].muscalar() = mu_trial.norm();         // update dip scalar in particle
                     if ( p[i].muscalar() > 1e-6 )
                         p[i].mu() = mu_trial / p[i].muscalar();      // update article dip.
@@ -192,14 +194,14 @@ namespace Faunus
         {
             Tmove::_rejectMove();
             if ( updateDip )
-                Tmove::spc->trial = Tmove::spc->p;
+                Tmove::spc->rejectTrial();
         }
 
         void _acceptMove() override
         {
             Tmove::_acceptMove();
             if ( updateDip )
-                Tmove::spc->p = Tmove::spc->trial;
+                Tmove::spc->acceptTrial();
         }
 
         string _info() override
@@ -302,6 +304,8 @@ namespace Faunus
 
         bool useAlternativeReturnEnergy;   //!< Return a different energy than returned by _energyChange(). [false]
         double alternateReturnEnergy;    //!< Alternative return energy
+        Energy::GroupPairCache<Tspace> *pairCache; //!< Cached group-group energies (optional)
+        Energy::RunningEnergy *runningEnergy;      //!< Running total system energy (optional)
 
         struct MolListData
         {
@@ -356,6 +360,8 @@ namespace Faunus
         }
 
     public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW // derived moves hold fixed-size Eigen members, over-aligned with AVX
+
         Movebase( Energy::Energybase<Tspace> &, Tspace & );//!< Constructor
         virtual ~Movebase();
         double
@@ -365,6 +371,21 @@ namespace Faunus
         void test( UnitTest & );              //!< Perform unit test
         double getAcceptance() const;      //!< Get acceptance [0:1]
 
+        /** @brief Use and maintain cached group-to-group energies, see `Energy::GroupPairCache` */
+        virtual void setPairCache( Energy::GroupPairCache<Tspace> &c ) { pairCache = &c; }
+
+        /** @brief Running total energy that the move may use instead of `Energy::systemEnergy()` */
+        void setRunningEnergy( Energy::RunningEnergy &u ) { runningEnergy = &u; }
+
+        /** @brief Discard cached and running energies, e.g. after the configuration was replaced */
+        virtual void invalidate()
+        {
+            if ( pairCache != nullptr )
+                pairCache->invalidate();
+            if ( runningEnergy != nullptr )
+                runningEnergy->invalidate();
+        }
+
         void addMol( int, const MolListData &d = MolListData()); //!< Specify molecule id to act upon
         Group *randomMol();
         int randomMolId();                 //!< Random mol id from mollist
@@ -407,6 +428,8 @@ namespace Faunus
         w = 30;
         runfraction = 1;
         useAlternativeReturnEnergy = false; //this has no influence on metropolis sampling!
+        pairCache = nullptr;
+        runningEnergy = nullptr;
         change.clear();
 #ifdef ENABLE_MPI
         mpiPtr=nullptr;
@@ -527,6 +550,7 @@ namespace Faunus
             while ( n-- > 0 )
             {
                 trialMove();
+                spc->syncArrays(change);
 		pot->updateChange(change);
                 double du = energyChange();
                 acceptance = metropolis(du);
@@ -540,7 +564,10 @@ namespace Faunus
                     dusum += du;
                     utot += du;
                 }
+                spc->syncArrays(change);
                 utot += pot->update(acceptance);
+                if ( pairCache != nullptr )
+                    pairCache->update(acceptance, change);
                 change.clear();
             }
         }
@@ -893,7 +920,8 @@ namespace Faunus
                 return pc::infty;
 	    
 	    //return Energy::energyChange(*spc, *base::pot, base::change);
-            return (base::pot->i_total(spc->trial, iparticle) + base::pot->external(spc->trial)) - (base::pot->i_total(spc->p, iparticle) + base::pot->external(spc->p));
+            return base::pot->i_total(spc->trial, iparticle) - base::pot->i_total(spc->p, iparticle)
+                + base::pot->externalChange(base::change);
         }
         return 0;
     }
@@ -1234,12 +1262,14 @@ namespace Faunus
         double dp_trans;   //!< Translational displacement parameter
         double angle;      //!< Temporary storage for current angle
         Point dir;         //!< Translation directions (default: x=y=z=1). This will be set by setGroup()
+        Energy::ParallelGroupEnergy<Tspace> parallel;
 
     public:
 
         TranslateRotate( Energy::Energybase<Tspace> &, Tspace &, Tmjson & );
         void setGroup( Group & ); //!< Select Group to move
         bool groupWiseEnergy;  //!< Attempt to evaluate energy over groups from vector in Space (default=false)
+        bool parallelGroups;   //!< Evaluate group-group energies with `Energy::ParallelGroupEnergy` (default=false)
         std::map<string, Point> directions; //!< Specify special group translation directions (default: x=y=z=1)
     };
 
@@ -1281,6 +1311,7 @@ namespace Faunus
         base::w = 30;
         igroup = nullptr;
         groupWiseEnergy = false;
+        parallelGroups = false;
 
         base::fillMolList(j);// find molecules to be moved
 
@@ -1382,10 +1413,10 @@ namespace Faunus
 	//return Energy::energyChange(*spc, *base::pot, base::change);
 
 	
-        double unew = pot->external(spc->trial) + pot->g_external(spc->trial, *igroup);
+        double unew = pot->externalChange(base::change) + pot->g_external(spc->trial, *igroup);
         if ( unew == pc::infty )
             return pc::infty;       // early rejection
-        double uold = pot->external(spc->p) + pot->g_external(spc->p, *igroup);
+        double uold = pot->g_external(spc->p, *igroup);
 
 #ifdef ENABLE_MPI
           if (base::mpiPtr!=nullptr) {
@@ -1400,6 +1431,12 @@ namespace Faunus
           }
 #endif
 
+        if ( base::pairCache != nullptr )
+            return (unew - uold) + base::pairCache->rowChange(spc->findIndex(igroup));
+
+        if ( parallelGroups )
+            return (unew - uold) + parallel.change(*pot, *spc, {igroup});
+
         for ( auto g : spc->groupList())
         {
             if ( g != igroup )
@@ -2824,9 +2861,12 @@ namespace Faunus
         if ( dp < 1e-6 )
             return u;
         size_t n = spc->groupList().size();  // number of groups
-        for ( size_t i = 0; i < n - 1; ++i )      // group-group
-            for ( size_t j = i + 1; j < n; ++j )
-                u += pot->g2g(p, *spc->groupList()[i], *spc->groupList()[j]);
+        if ( base::pairCache != nullptr )
+            u += (&p == &spc->p) ? base::pairCache->total() : base::pairCache->trialTotal();
+        else
+            for ( size_t i = 0; i < n - 1; ++i )      // group-group
+                for ( size_t j = i + 1; j < n; ++j )
+                    u += pot->g2g(p, *spc->groupList()[i], *spc->groupList()[j]);
 
         for ( auto g : spc->groupList())
         {
@@ -3876,6 +3916,7 @@ namespace Faunus
 
           double currentEnergy;         //!< Energy of configuration before move (uold)
           bool haveCurrentEnergy;       //!< True if currentEnergy has been set
+          bool defaultEnergy;           //!< True if `usys` is `Energy::systemEnergy`
 
           string _info() override;
           void _trialMove() override;
@@ -3919,6 +3960,7 @@ namespace Faunus
 
         setEnergyFunction(
             Energy::systemEnergy<Tspace,Energy::Energybase<Tspace>,Tpvec> );
+        defaultEnergy=true;
 
         this->haveCurrentEnergy=false;
 
@@ -3932,6 +3974,7 @@ namespace Faunus
     template<class Tspace>
       void ParallelTempering<Tspace>::setEnergyFunction( Tenergyfunc f ) {
         usys = f;
+        defaultEnergy = false; // running energy refers to Energy::systemEnergy
       }
 
     template<class Tspace>
@@ -3988,6 +4031,7 @@ namespace Faunus
           pt.send(*mpiPtr, spc->p, partner);     // send everything
           pt.waitrecv();
           pt.waitsend();
+          spc->touchAll();                       // whole configuration replaced
 
           // update group trial mass-centers. Needed if energy calc. uses
           // cm_trial for cut-offs, for example
@@ -4023,6 +4067,8 @@ namespace Faunus
 
         if (haveCurrentEnergy)   // do we already know the energy?
           uold = currentEnergy;
+        else if (defaultEnergy && base::runningEnergy!=nullptr)
+          uold = base::runningEnergy->current();
         else
           uold = usys(*spc,*pot,spc->p);
 
@@ -4066,8 +4112,7 @@ namespace Faunus
         if ( goodPartner() ) {
           //temperPath << cnt << " " << partner << endl;
           accmap[ id() ] += 1;
-          for (size_t i=0; i<spc->p.size(); i++)
-            spc->p[i] = spc->trial[i];  // copy new configuration
+          spc->acceptTrial();         // copy new configuration
           for (auto g : spc->groupList())
             g->cm = g->cm_trial;
         }
@@ -4079,14 +4124,201 @@ namespace Faunus
           spc->geo.setVolume( pt.sendExtra[VOLUME] ); // restore old volume
           pot->setSpace(*spc);
           accmap[ id() ] += 0;
-          for (size_t i=0; i<spc->p.size(); i++)
-            spc->trial[i] = spc->p[i];   // restore old configuration
+          spc->rejectTrial();         // restore old configuration
           for (auto g : spc->groupList())
             g->cm_trial = g->cm;
         }
       }
 #endif
 
+    /**
+     * @brief Replica exchange between Space/Hamiltonian pairs within one process
+     *
+     * Shared-memory alternative to `ParallelTempering` that keeps all
+     * replicas in a single process. Each replica is a `Space`, a Hamiltonian
+     * and a move (typically a `Propagator`) that are added with `add()`.
+     * Temperatures or other differences are defined by the Hamiltonians, as
+     * for `ParallelTempering`, and global read-only data such as the atom
+     * list or cached tables is shared by all replicas.
+     *
+     * `propagate()` moves all replicas, concurrently over OpenMP threads if
+     * `parallel` is set, and `exchange()` attempts to swap configurations of
+     * neighbouring replicas, alternating between even and odd pairs.
+     * A swap exchanges the particle vectors of the two spaces in constant
+     * time, along with mass centers and geometries; no particles are
+     * serialized or copied. The swap is accepted with probability
+     * \f$ \min(1, e^{-\Delta}) \f$ where
+     * \f$ \Delta = U_a(x_b) - U_a(x_a) + U_b(x_a) - U_b(x_b) \f$.
+     *
+     * All spaces must have the same number of particles and groups.
+     * After a swap, `Energy::Energybase::refresh()` is called so that energy
+     * terms rebuild data derived from the old configuration, while cached
+     * and running energies of the moves are discarded with
+     * `Movebase::invalidate()`. Energy drift checks of the individual moves
+     * do not include accepted swaps. With `parallel` set, the moves must not share
+     * unguarded state other than the random number generator. As all
+     * replicas draw from the shared `slump`, the random sequence then
+     * depends on thread timing and parallel runs are not reproducible.
+     *
+     * Example:
+     *
+     *     Move::ReplicaExchange<Tspace> rex;
+     *     for (int r=0; r<R; r++)
+     *       rex.add(*spc[r], *pot[r], *mv[r]);
+     *     for (int i=0; i<macro; i++) {
+     *       rex.propagate(micro);
+     *       rex.exchange();
+     *     }
+     */
+    template<class Tspace>
+    class ReplicaExchange
+    {
+    public:
+        typedef typename Tspace::ParticleVector Tpvec;
+        typedef std::function<double( Tspace &, Energy::Energybase<Tspace> &, const Tpvec & )> Tenergyfunc;
+
+    private:
+        struct Replica
+        {
+            Tspace *spc;
+            Energy::Energybase<Tspace> *pot;
+            Movebase<Tspace> *mv;
+        };
+
+        std::vector<Replica> replicas;
+        std::vector<int> walker;         // configuration id in each replica
+        std::vector<double> du;          // energy change for each attempted pair
+        std::map<string, Average<double> > accmap;
+        Tenergyfunc usys;                // defaults to Energy::systemEnergy
+        int parity;                      // first replica of pairs in next exchange (0 or 1)
+
+        /** @brief Swap configurations of replicas `a` and `b` */
+        void swap( Replica &a, Replica &b )
+        {
+            std::swap(a.spc->p, b.spc->p);
+            std::swap(a.spc->trial, b.spc->trial);
+            auto &ga = a.spc->groupList();
+            auto &gb = b.spc->groupList();
+            for ( size_t i = 0; i < ga.size(); i++ )
+            {
+                std::swap(ga[i]->cm, gb[i]->cm);
+                std::swap(ga[i]->cm_trial, gb[i]->cm_trial);
+            }
+            std::swap(a.spc->geo, b.spc->geo);
+            std::swap(a.spc->geo_trial, b.spc->geo_trial);
+            for ( auto r : {&a, &b} )
+            {
+                r->spc->syncArrays();
+                r->pot->refresh();
+                r->pot->setSpace(*r->spc);
+                r->mv->invalidate();
+            }
+        }
+
+        string id( int a ) const
+        {
+            std::ostringstream o;
+            o << a << " <-> " << a + 1;
+            return o.str();
+        }
+
+    public:
+        bool parallel; //!< Propagate replicas and evaluate swaps concurrently (default: false)
+
+        ReplicaExchange() : parity(0), parallel(false)
+        {
+            usys = Energy::systemEnergy<Tspace, Energy::Energybase<Tspace>, Tpvec>;
+        }
+
+        /** @brief Add replica; neighbouring replicas in order of addition are swap partners */
+        void add( Tspace &s, Energy::Energybase<Tspace> &e, Movebase<Tspace> &m )
+        {
+            if ( !replicas.empty())
+            {
+                Tspace &s0 = *replicas.front().spc;
+                if ( s.p.size() != s0.p.size() || s.groupList().size() != s0.groupList().size())
+                    throw std::runtime_error("Replica exchange: replicas must have identical topology");
+            }
+            e.setSpace(s);
+            walker.push_back(replicas.size());
+            replicas.push_back(Replica{&s, &e, &m});
+        }
+
+        /** @brief Replace function used for system energies */
+        void setEnergyFunction( Tenergyfunc f ) { usys = f; }
+
+        int size() const { return replicas.size(); } //!< Number of replicas
+
+        /** @brief Id of configuration currently in each replica (initially `0,1,2...`) */
+        const std::vector<int> &walkers() const { return walker; }
+
+        /** @brief Perform `n` moves in each replica and return summed energy change */
+        double propagate( int n = 1 )
+        {
+            double u = 0;
+            int R = replicas.size();
+#pragma omp parallel for reduction (+:u) schedule (dynamic) if (parallel)
+            for ( int r = 0; r < R; r++ )
+                for ( int i = 0; i < n; i++ )
+                    u += replicas[r].mv->move();
+            return u;
+        }
+
+        /** @brief Attempt to swap all even or all odd neighbour pairs; returns number of accepted swaps */
+        int exchange()
+        {
+            int R = replicas.size();
+            int first = parity;
+            parity = 1 - parity;
+            du.assign(R, 0);
+
+            // disjoint pairs are independent and evaluated concurrently
+#pragma omp parallel for schedule (dynamic) if (parallel)
+            for ( int a = first; a < R - 1; a += 2 )
+            {
+                Replica &A = replicas[a], &B = replicas[a + 1];
+                double uold = usys(*A.spc, *A.pot, A.spc->p) + usys(*B.spc, *B.pot, B.spc->p);
+                swap(A, B);
+                double unew = usys(*A.spc, *A.pot, A.spc->p) + usys(*B.spc, *B.pot, B.spc->p);
+                du[a] = unew - uold;
+            }
+
+            // Metropolis decisions are drawn serially, in replica order
+            int accepted = 0;
+            for ( int a = first; a < R - 1; a += 2 )
+            {
+                if ( slump() > std::exp(-du[a]))
+                {
+                    swap(replicas[a], replicas[a + 1]); // restore
+                    accmap[id(a)] += 0;
+                }
+                else
+                {
+                    std::swap(walker[a], walker[a + 1]);
+                    accmap[id(a)] += 1;
+                    accepted++;
+                }
+            }
+            return accepted;
+        }
+
+        string info()
+        {
+            using namespace textio;
+            std::ostringstream o;
+            o << header("Replica Exchange")
+              << pad(SUB, 30, "Number of replicas") << replicas.size() << endl
+              << pad(SUB, 30, "Concurrent replicas") << std::boolalpha << parallel << endl
+              << indent(SUB) << "Acceptance:" << endl;
+            o.precision(3);
+            for ( auto &m : accmap )
+                o << indent(SUBSUB) << std::left << setw(12)
+                  << m.first << setw(8) << m.second.cnt << m.second.avg() * 100
+                  << percent << endl;
+            return o.str();
+        }
+    };
+
     /**
      * @brief Swap atom charges
      *
@@ -5029,12 +5261,13 @@ namespace Faunus
         double dusum; // sum of all energy *changes* by moves
         Average<double> uavg; // average system energy
         std::function<double()> ufunction; // function to calculate system energy
+        Energy::RunningEnergy running; // uinit + dusum, periodically recomputed with ufunction
 
         string _info() override
         {
             using namespace textio;
 
-            double ucurr = ufunction(); // current system energy
+            double ucurr = running.resync(); // current system energy
 
             std::ostringstream o;
             if ( uavg.cnt > 0 )
@@ -5044,7 +5277,9 @@ namespace Faunus
                   << pad(SUB, base::w, "Current energy") << ucurr << kT << "\n"
                   << pad(SUB, base::w, "Changed") << dusum << kT << "\n"
                   << pad(SUB, base::w, "Absolute drift") << ucurr - (uinit + dusum) << kT << "\n"
-                  << pad(SUB, base::w, "Relative drift") << (ucurr - (uinit + dusum)) / uinit * 100 << percent << "\n";
+                  << pad(SUB, base::w, "Relative drift") << (ucurr - (uinit + dusum)) / uinit * 100 << percent << "\n"
+                  << pad(SUB, base::w, "Running energy resync") << running.resyncInterval << "\n"
+                  << pad(SUB, base::w, "Running energy max. drift") << running.maxDrift() << kT << "\n";
 
                 for ( auto &i : mPtr )
                     o << i->info();
@@ -5094,6 +5329,9 @@ namespace Faunus
                         if (val.is_string())
                             jsonfile = val;
 
+                    if ( i.key() == "_resync" )
+                        running.resyncInterval = val.get<unsigned long>();
+
                     base::_slump().eng = slump.eng; // seed from global slump() instance
 
                     if ( i.key() == "random" )
@@ -5157,6 +5395,9 @@ namespace Faunus
             ufunction = std::bind(
                 Energy::systemEnergy<Tspace, Tenergy, typename Tspace::ParticleVector>,
                 ref(s), ref(e), ref(s.p));
+            running.setFunction([this]() { return ufunction(); });
+            for ( auto &i : mPtr )
+                i->setRunningEnergy(running);
         }
 
         ~Propagator()
@@ -5184,14 +5425,24 @@ namespace Faunus
                 return du;
 
             if ( uavg.cnt == 0 )
-                uinit = ufunction(); // calculate initial energy, prior to any moves
+                uinit = running.resync(); // calculate initial energy, prior to any moves
 
             du = (*base::_slump().element(mPtr.begin(), mPtr.end()))->move();
             dusum += du;
-            uavg += uinit + dusum; // sample average system energy
+            running.add(du);
+            uavg += running.current(); // sample average system energy
             return du;  // return energy change
         }
 
+        /**
+         * @brief Running total system energy
+         *
+         * Initial energy plus energy changes of all moves, recomputed every
+         * `_resync` moves (JSON key in `moves`, default 1000). Call
+         * `invalidate()` on it if the system is changed outside the propagator.
+         */
+        Energy::RunningEnergy &runningEnergy() { return running; }
+
         /** @brief Generate JSON object w. move information */
         Tmjson json()
         {
@@ -5209,13 +5460,32 @@ namespace Faunus
                 i->test(t);
 
             if (uavg.cnt>0) {
-              double ucurr = ufunction();
+              double ucurr = running.resync();
               double drift = ucurr - (uinit + dusum);
               t("energyAverage", uavg.avg());
               t("relativeEnergyDrift", std::abs(drift / ucurr), 10.0);
             }
         }
 
+        /** @brief Use cached group-to-group energies in all moves and for drift checks */
+        void setPairCache( Energy::GroupPairCache<Tspace> &c ) override
+        {
+            base::setPairCache(c);
+            for ( auto &i : mPtr )
+                i->setPairCache(c);
+            auto s = base::spc;
+            auto e = base::pot;
+            ufunction = [s, e, &c]() { return Energy::cachedSystemEnergy(*s, *e, c); };
+        }
+
+        void invalidate() override
+        {
+            base::invalidate();
+            for ( auto &i : mPtr )
+                i->invalidate();
+            running.invalidate();
+        }
+
 #ifdef ENABLE_MPI
         void setMPI( Faunus::MPI::MPIController* mpi )
         {
@@ -405,6 +405,9 @@ namespace Faunus {
          *  `cutoff`      |  Spherical cutoff in angstroms
          *  `epsr`        |  Relative dielectric constant of the medium
          *
+         *  Splitting functions are stored in and loaded from the on-disk
+         *  table cache if enabled, see `Tabulate::TableCache`.
+         *
          *  More info:
          * 
          *  - On the dielectric constant, http://dx.doi.org/10.1080/00268978300102721
@@ -416,20 +419,26 @@ namespace Faunus {
                 Tabulate::TabulatorBase<double>::data table; // data for splitting function
                 std::function<double(double)> calcDielectric; // function for dielectric const. calc.
                 string type;
+                string cachekey; // splitting function and its parameters
 		double selfenergy_prefactor;
                 double lB, depsdt, rc, rc2, rc1i, epsr, epsrf, alpha, kappa, I;
                 int order;
 
+                /** @brief Tabulate splitting function unless found in the on-disk cache */
+                Tabulate::TabulatorBase<double>::data generate(std::function<double(double)> f) {
+                    return Tabulate::TableCache::generate(sf, cachekey, f);
+                }
+
                 void sfYukawa(const Tmjson &j) {
                     kappa = 1.0 / j.at("debyelength").get<double>();
                     I = kappa*kappa / ( 8.0*lB*pc::pi*pc::Nav/1e27 );
-                    table = sf.generate( [&](double q) { return std::exp(-q*rc*kappa) - std::exp(-kappa*rc); } ); // q=r/Rc 
+                    table = generate( [&](double q) { return std::exp(-q*rc*kappa) - std::exp(-kappa*rc); } ); // q=r/Rc 
                     // we could also fill in some info string or JSON output...
                 }
 
                 void sfReactionField(const Tmjson &j) {
                     epsrf = j.at("eps_rf");
-                    table = sf.generate( [&](double q) { return 1 + (( epsrf - epsr ) / ( 2 * epsrf + epsr ))*q*q*q - 3 * ( epsrf / ( 2 * epsrf + epsr ))*q ; } ); 
+                    table = generate( [&](double q) { return 1 + (( epsrf - epsr ) / ( 2 * epsrf + epsr ))*q*q*q - 3 * ( epsrf / ( 2 * epsrf + epsr ))*q ; } ); 
                     calcDielectric = [&](double M2V) {
                         if(epsrf > 1e10)
                             return 1 + 3*M2V;
@@ -447,7 +456,7 @@ namespace Faunus {
                 void sfQpotential(const Tmjson &j)
                 {
                     order = j.value("order",300);
-                    table = sf.generate( [&](double q) { return qPochhammerSymbol( q, 1, order ); } );
+                    table = generate( [&](double q) { return qPochhammerSymbol( q, 1, order ); } );
                     calcDielectric = [&](double M2V) { return 1 + 3*M2V; };
 		    selfenergy_prefactor = 0.5;
                 }
@@ -455,20 +464,20 @@ namespace Faunus {
                 void sfYonezawa(const Tmjson &j)
                 {
                     alpha = j.at("alpha");
-                    table = sf.generate( [&](double q) { return 1 - erfc(alpha*rc)*q + q*q; } );
+                    table = generate( [&](double q) { return 1 - erfc(alpha*rc)*q + q*q; } );
 		    calcDielectric = [&](double M2V) { return 1 + 3*M2V; };
 		    selfenergy_prefactor = erf(alpha*rc);
                 }
 
                 void sfFanourgakis(const Tmjson &j) {
-                    table = sf.generate( [&](double q) { return 1 - 1.75*q + 5.25*pow(q,5) - 7*pow(q,6) + 2.5*pow(q,7); } );
+                    table = generate( [&](double q) { return 1 - 1.75*q + 5.25*pow(q,5) - 7*pow(q,6) + 2.5*pow(q,7); } );
                     calcDielectric = [&](double M2V) { return 1 + 3*M2V; };
 		    selfenergy_prefactor = 0.875;
                 }
 
                 void sfFennel(const Tmjson &j) {
                     alpha = j.at("alpha");
-                    table = sf.generate( [&](double q) { return (erfc(alpha*rc*q) - erfc(alpha*rc)*q + (q-1.0)*q*(erfc(alpha*rc) + 2 * alpha * rc / sqrt(pc::pi) * exp(-alpha*alpha*rc*rc))); } );
+                    table = generate( [&](double q) { return (erfc(alpha*rc*q) - erfc(alpha*rc)*q + (q-1.0)*q*(erfc(alpha*rc) + 2 * alpha * rc / sqrt(pc::pi) * exp(-alpha*alpha*rc*rc))); } );
 		    calcDielectric = [&](double M2V) { double T = erf(alpha*rc) - (2 / (3 * sqrt(pc::pi))) * exp(-alpha*alpha*rc*rc) * (alpha*alpha*rc*rc * alpha*alpha*rc*rc + 2.0 * alpha*alpha*rc*rc + 3.0);
 						       return (((T + 2.0) * M2V + 1.0)/ ((T - 1.0) * M2V + 1.0)); };
 		    selfenergy_prefactor = ( erfc(alpha*rc)/2.0 + alpha*rc/sqrt(pc::pi) );
@@ -476,14 +485,14 @@ namespace Faunus {
 
                 void sfWolf(const Tmjson &j) {
                     alpha = j.at("alpha");
-                    table = sf.generate( [&](double q) { return (erfc(alpha*rc*q) - erfc(alpha*rc)*q); } );
+                    table = generate( [&](double q) { return (erfc(alpha*rc*q) - erfc(alpha*rc)*q); } );
 		    calcDielectric = [&](double M2V) { double T = erf(alpha*rc) - (2 / (3 * sqrt(pc::pi))) * exp(-alpha*alpha*rc*rc) * ( 2.0 * alpha*alpha*rc*rc + 3.0);
 						       return (((T + 2.0) * M2V + 1.0)/ ((T - 1.0) * M2V + 1.0));};
 		    selfenergy_prefactor = ( erfc(alpha*rc) + alpha*rc/sqrt(pc::pi)*(1.0 + exp(-alpha*alpha*rc2)) );
                 }
 
                 void sfPlain(const Tmjson &j, double val=1) {
-                    table = sf.generate( [&](double q) { return val; } );
+                    table = generate( [&](double q) { return val; } );
 		    calcDielectric = [&](double M2V) { return (2.0*M2V + 1.0)/(1.0 - M2V); };
 		    selfenergy_prefactor = 0.0;
                 }
@@ -503,6 +512,7 @@ namespace Faunus {
                         sf.setRange(0, 1);
                         sf.setTolerance(
                                 j.value("tab_utol",1e-9),j.value("tab_ftol",1e-2) );
+                        cachekey = "CoulombGalore|" + j.dump();
 
                         if (type=="reactionfield") sfReactionField(j);
                         if (type=="fanourgakis") sfFanourgakis(j);
@@ -534,6 +544,22 @@ namespace Faunus {
                         return 0;
                     }
 
+                /**
+                 * @brief Add energies of `a` with block of partners to `u`
+                 *
+                 * Only the distance part is vectorised as the splitting
+                 * function is evaluated by table lookup.
+                 */
+                template<class Tparticle>
+                    void block(const Tparticle &a, const PairBlock &b, double *u) const {
+                        double lBq = lB * a.charge;
+                        for (int k=0; k<b.size; k++)
+                            if (b.r2[k] < rc2) {
+                                double r = sqrt(b.r2[k]);
+                                u[k] += lBq * b.charge[k] / r * sf.eval( table, r*rc1i );
+                            }
+                    }
+
                 template<class Tparticle>
                     double operator()(const Tparticle &a, const Tparticle &b, const Point &r) const {
                         return operator()(a,b,r.squaredNorm());
@@ -589,6 +615,8 @@ namespace Faunus {
                 }
         };
 
+        template<> struct hasBlock<CoulombGalore> : std::true_type {};
+
         /**
          * @brief Help-function for `sfQpotential` using order 3.
          */
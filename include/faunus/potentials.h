@@ -118,6 +118,32 @@ namespace Faunus {
         virtual std::string info(char=20);
     };
 
+    /**
+     * @brief Block of pair partners stored in contiguous arrays
+     *
+     * Pair potentials with a `block()` function evaluate the energy of
+     * one particle with all partners in the block in a single loop that
+     * the compiler can vectorise. Use `ENABLE_SIMD` to target the
+     * instruction set (AVX2, AVX-512) of the host CPU.
+     */
+    struct PairBlock {
+      const double *r2;     //!< Squared distances (angstrom^2)
+      const double *charge; //!< Partner charges
+      const double *radius; //!< Partner radii
+      const int *id;        //!< Partner atom ids
+      int size;             //!< Number of partners
+    };
+
+    /**
+     * @brief Determines if a pair potential implements `block()`
+     *
+     * `block(a, b, u)` must add the energy of particle `a` with each
+     * partner in the `PairBlock` `b` to the array `u`. The result
+     * must equal that of the scalar `operator()` to within round-off.
+     */
+    template<class Tpairpot>
+      struct hasBlock : std::false_type {};
+
     /**
      * @brief Save pair potential and force table to disk
      *
@@ -561,6 +587,16 @@ namespace Faunus {
             double x(r6(a.radius+b.radius,r2));
             return eps*(x*x - x);
           }
+
+        /** @brief Add energies of `a` with block of partners to `u` */
+        template<class Tparticle>
+          void block(const Tparticle &a, const PairBlock &b, double *u) const {
+#pragma omp simd
+            for (int k=0; k<b.size; k++) {
+              double x(r6(a.radius+b.radius[k],b.r2[k]));
+              u[k] += eps*(x*x - x);
+            }
+          }
         template<class Tparticle>
           double operator() (const Tparticle &a, const Tparticle &b, const Point &r) {
             return operator()(a,b,r.squaredNorm());
@@ -712,6 +748,18 @@ namespace Faunus {
               return eps(a.id,b.id) * (x*x - x);
             }
 
+          /** @brief Add energies of `a` with block of partners to `u` */
+          template<class Tparticle>
+            void block(const Tparticle &a, const PairBlock &b, double *u) const {
+              const double *s2row = s2.m[a.id].data(), *epsrow = eps.m[a.id].data();
+#pragma omp simd
+              for (int k=0; k<b.size; k++) {
+                double x=s2row[b.id[k]]/b.r2[k];
+                x=x*x*x;
+                u[k] += epsrow[b.id[k]] * (x*x - x);
+              }
+            }
+
           template<typename Tparticle>
             Point force(const Tparticle &a, const Tparticle &b, double r2, const Point &p) {
               double s6=_powi<3>( s2(a.id,b.id) );
@@ -1099,6 +1147,19 @@ namespace Faunus {
 #endif
         }
 
+      /** @brief Add energies of `a` with block of partners to `u` */
+      template<class Tparticle>
+        void block(const Tparticle &a, const PairBlock &b, double *u) const {
+          double lBq = lB*a.charge;
+#pragma omp simd
+          for (int k=0; k<b.size; k++)
+#ifdef FAU_APPROXMATH
+            u[k] += lBq*b.charge[k] * invsqrtQuake(b.r2[k]);
+#else
+            u[k] += lBq*b.charge[k] / sqrt(b.r2[k]);
+#endif
+        }
+
       template<class Tparticle>
         double operator() (const Tparticle &a, const Tparticle &b, const Point &r) {
           return operator()(a,b,r.squaredNorm());
@@ -1168,6 +1229,23 @@ namespace Faunus {
 #endif
           }
 
+        /** @brief Add energies of `a` with block of partners to `u` */
+        template<class Tparticle>
+          void block(const Tparticle &a, const PairBlock &b, double *u) const {
+            const double *row = lBxQQ.m[a.id].data();
+#pragma omp simd
+            for (int k=0; k<b.size; k++) {
+#ifdef FAU_APPROXMATH
+              double ri=invsqrtQuake(b.r2[k]);
+              double e = row[b.id[k]] * (ri - Rcinv + (Rcinv/ri-1)*Rcinv );
+#else
+              double r=sqrt(b.r2[k]);
+              double e = row[b.id[k]] * (1/r - Rcinv + (r*Rcinv-1)*Rcinv );
+#endif
+              u[k] += (b.r2[k]>Rc2) ? 0 : e;
+            }
+          }
+
         template<class Tparticle>
           double operator() (const Tparticle &a, const Tparticle &b, const Point &r) {
             return operator()(a,b,r.squaredNorm());
@@ -1342,6 +1420,22 @@ namespace Faunus {
 #endif
           }
 
+        /** @brief Add energies of `a` with block of partners to `u` */
+        template<class Tparticle>
+          void block(const Tparticle &a, const PairBlock &b, double *u) const {
+            double lBq = lB * a.charge;
+#pragma omp simd
+            for (int i=0; i<b.size; i++) {
+#ifdef FAU_APPROXMATH
+              double rinv = invsqrtQuake(b.r2[i]);
+              u[i] += lBq * b.charge[i] * rinv * exp_cawley(-k/rinv);
+#else
+              double r=sqrt(b.r2[i]);
+              u[i] += lBq * b.charge[i] / r * exp(-k*r);
+#endif
+            }
+          }
+
         double entropy(double, double) const;         //!< Returns the interaction entropy
         double ionicStrength() const;                 //!< Returns the ionic strength (mol/l)
         double debyeLength() const;                   //!< Returns the Debye screening length (angstrom)
@@ -1665,6 +1759,9 @@ namespace Faunus {
      *
      * If the pair is not recognized, i.e. not added with the
      * `add()` function, the `Tdefault` pair potential is used.
+     * Potentials are looked up in a dense table indexed by the
+     * two particle types; see `PotentialMatrix` for a variant
+     * that also avoids calls through `std::function`.
      *
      * Example:
      *
@@ -1675,11 +1772,12 @@ namespace Faunus {
     template<typename Tdefault, typename Tparticle=PointParticle, typename Tdist=double>
       class PotentialMap : public Tdefault {
         protected:
-          typedef opair<int> Tpair;
           typedef std::function<double(const Tparticle&,const Tparticle&,Tdist)> Tfunc;
           typedef std::function<Point(const Tparticle&,const Tparticle&,double,const Point&)> Tforce;
-          std::map<Tpair,Tfunc> m;
-          std::map<Tpair,Tforce> mforce;
+          vector<Tfunc> m;
+          vector<Tforce> mforce;
+          vector<int> index;  // ntypes x ntypes table of added potentials; -1 for default
+          size_t ntypes;
           std::string _info; // info for the added potentials (before turning into functors)
 
           // Force function object wrapper class
@@ -1692,8 +1790,27 @@ namespace Faunus {
               }
             };
 
+          /** @brief Index of potential for pair of particles; -1 if default */
+          inline int find(const Tparticle &a, const Tparticle &b) const {
+            if (a.id < ntypes && b.id < ntypes)
+              return index[a.id*ntypes + b.id];
+            return -1;
+          }
+
+          /** @brief Grow pair table to `n`x`n`, preserving entries */
+          void resize(size_t n) {
+            if (n <= ntypes)
+              return;
+            vector<int> t(n*n, -1);
+            for (size_t i=0; i<ntypes; i++)
+              for (size_t j=0; j<ntypes; j++)
+                t[i*n + j] = index[i*ntypes + j];
+            index.swap(t);
+            ntypes = n;
+          }
+
         public:
-          PotentialMap(Tmjson &j) : Tdefault(j) {
+          PotentialMap(Tmjson &j) : Tdefault(j), ntypes(0) {
             Tdefault::name += " (default)";
           }
 
@@ -1705,21 +1822,29 @@ namespace Faunus {
             void add(AtomData::Tid id1, AtomData::Tid id2, Tpairpot pot) {
               pot.name=atom[id1].name + "<->" + atom[id2].name + ": " + pot.name;
               _info+="\n  " + pot.name + ":\n" + pot.info(20);
-              m[Tpair(id1,id2)] = pot;
-              mforce[Tpair(id1,id2)] = ForceFunctionObject<decltype(pot)>(pot);
+              resize( std::max(size_t(std::max(id1,id2))+1, atom.size()) );
+              int &i = index[id1*ntypes + id2];
+              if (i < 0) {
+                i = index[id2*ntypes + id1] = m.size();
+                m.push_back( pot );
+                mforce.push_back( ForceFunctionObject<decltype(pot)>(pot) );
+              } else {
+                m[i] = pot;
+                mforce[i] = ForceFunctionObject<decltype(pot)>(pot);
+              }
             }
 
           double operator()(const Tparticle &a, const Tparticle &b, const Tdist &r2) {
-            auto i=m.find( Tpair(a.id,b.id) );
-            if (i!=m.end())
-              return i->second(a,b,r2);
+            int i=find(a,b);
+            if (i>=0)
+              return m[i](a,b,r2);
             return Tdefault::operator()(a,b,r2);
           }
 
           Point force(const Tparticle &a, const Tparticle &b, double r2, const Point &p) {
-            auto i=mforce.find( Tpair(a.id,b.id) );
-            if (i!=mforce.end())
-              return i->second(a,b,r2,p);
+            int i=find(a,b);
+            if (i>=0)
+              return mforce[i](a,b,r2,p);
             return Tdefault::force(a,b,r2,p);
           }
 
@@ -1728,6 +1853,127 @@ namespace Faunus {
           }
       };
 
+    /**
+     * @brief Custom potentials between specific particle types from a fixed set of types
+     *
+     * As `PotentialMap` but the possible pair potential types are given at compile
+     * time. Added potentials are stored by value, one vector per type, and a dense
+     * `ntypes` x `ntypes` table holds the type and position of the potential for each
+     * pair of particle types. Evaluation is thus a table lookup followed by a direct,
+     * inlinable call with neither tree lookups nor `std::function` overhead.
+     * Pairs not added use `Tdefault`.
+     *
+     * Example:
+     *
+     *     PotentialMatrix<CoulombLJ, ChargeNonpolar, Harmonic> pot(...);
+     *     pot.add( atom["Na"].id ,atom["CH4"].id, ChargeNonpolar(...) );
+     *     pot.add( atom["Cl"].id ,atom["CH4"].id, ChargeNonpolar(...) );
+     *     pot.add( atom["CH4"].id ,atom["CH4"].id, Harmonic(...) );
+     */
+    template<typename Tdefault, typename... Tpairpots>
+      class PotentialMatrix : public Tdefault {
+        private:
+          static_assert(sizeof...(Tpairpots) < 255, "too many pair potential types");
+
+          /** @brief Position of `T` in `Ts` */
+          template<class T, class... Ts> struct TypeIndex;
+          template<class T, class... Ts> struct TypeIndex<T, T, Ts...> { enum { value = 0 }; };
+          template<class T, class U, class... Ts> struct TypeIndex<T, U, Ts...> {
+            enum { value = 1 + TypeIndex<T, Ts...>::value };
+          };
+
+          struct Entry {
+            unsigned char type;   // 0 for default, otherwise position in `Tpairpots` plus one
+            int n;                // position in vector of potentials of that type
+          };
+
+          std::tuple<vector<Tpairpots>...> pots;
+          vector<Entry> table;    // ntypes x ntypes
+          size_t ntypes;
+          std::string _info;
+
+          /** @brief Entry for pair of types; types added after construction use `Tdefault` */
+          inline Entry entry(AtomData::Tid i, AtomData::Tid j) const {
+            if (size_t(i) >= ntypes || size_t(j) >= ntypes)
+              return Entry{0,0};
+            return table[i*ntypes + j];
+          }
+
+          void resize(size_t n) {
+            if (n <= ntypes)
+              return;
+            vector<Entry> t(n*n, Entry{0,0});
+            for (size_t i=0; i<ntypes; i++)
+              for (size_t j=0; j<ntypes; j++)
+                t[i*n + j] = table[i*ntypes + j];
+            table.swap(t);
+            ntypes = n;
+          }
+
+          template<size_t I, class Tparticle, class Tdist>
+            typename std::enable_if<I == sizeof...(Tpairpots), double>::type
+            evalEnergy(const Entry&, const Tparticle&, const Tparticle&, const Tdist&) { return 0; }
+
+          template<size_t I, class Tparticle, class Tdist>
+            typename std::enable_if<I < sizeof...(Tpairpots), double>::type
+            evalEnergy(const Entry &e, const Tparticle &a, const Tparticle &b, const Tdist &r2) {
+              if (e.type == I+1)
+                return std::get<I>(pots)[e.n](a,b,r2);
+              return evalEnergy<I+1>(e,a,b,r2);
+            }
+
+          template<size_t I, class Tparticle>
+            typename std::enable_if<I == sizeof...(Tpairpots), Point>::type
+            evalForce(const Entry&, const Tparticle&, const Tparticle&, double, const Point&) { return Point(0,0,0); }
+
+          template<size_t I, class Tparticle>
+            typename std::enable_if<I < sizeof...(Tpairpots), Point>::type
+            evalForce(const Entry &e, const Tparticle &a, const Tparticle &b, double r2, const Point &p) {
+              if (e.type == I+1)
+                return std::get<I>(pots)[e.n].force(a,b,r2,p);
+              return evalForce<I+1>(e,a,b,r2,p);
+            }
+
+        public:
+          PotentialMatrix(Tmjson &j) : Tdefault(j), ntypes(0) {
+            Tdefault::name += " (default)";
+            resize(atom.size());
+          }
+
+          /** @brief Use `pot` for pairs of particle types `id1` and `id2` */
+          template<class Tpairpot>
+            void add(AtomData::Tid id1, AtomData::Tid id2, Tpairpot pot) {
+              enum { I = TypeIndex<Tpairpot, Tpairpots...>::value };
+              pot.name=atom[id1].name + "<->" + atom[id2].name + ": " + pot.name;
+              _info+="\n  " + pot.name + ":\n" + pot.info(20);
+              resize(size_t(std::max(id1,id2))+1);
+              auto &v = std::get<I>(pots);
+              Entry e{ (unsigned char)(I+1), int(v.size()) };
+              v.push_back(pot);
+              table[id1*ntypes + id2] = table[id2*ntypes + id1] = e;
+            }
+
+          template<class Tparticle, class Tdist>
+            double operator()(const Tparticle &a, const Tparticle &b, const Tdist &r2) {
+              const Entry e = entry(a.id, b.id);
+              if (e.type == 0)
+                return Tdefault::operator()(a,b,r2);
+              return evalEnergy<0>(e,a,b,r2);
+            }
+
+          template<class Tparticle>
+            Point force(const Tparticle &a, const Tparticle &b, double r2, const Point &p) {
+              const Entry e = entry(a.id, b.id);
+              if (e.type == 0)
+                return Tdefault::force(a,b,r2,p);
+              return evalForce<0>(e,a,b,r2,p);
+            }
+
+          std::string info(char w=20) {
+            return Tdefault::info(w) + _info;
+          }
+      };
+
     /**
      * @brief Combines two pair potentials
      * @details This combines two PairPotentialBases. The combined potential
@@ -1785,6 +2031,13 @@ namespace Faunus {
               return first(a,b,r2) + second(a,b,r2);
             }
 
+          /** @brief Add energies of `a` with block of partners to `u` */
+          template<class Tparticle>
+            void block(const Tparticle &a, const PairBlock &b, double *u) const {
+              first.block(a,b,u);
+              second.block(a,b,u);
+            }
+
           template<typename Tparticle>
             Point force(const Tparticle &a, const Tparticle &b, double r2, const Point &p) {
               return first.force(a,b,r2,p) + second.force(a,b,r2,p);
@@ -1900,6 +2153,15 @@ namespace Faunus {
           return *( new Scale<Tpairpot>(pot,s) );
         }
 
+    /* pair potentials implementing `block()`, see `hasBlock` */
+    template<> struct hasBlock<Coulomb> : std::true_type {};
+    template<> struct hasBlock<CoulombWolf> : std::true_type {};
+    template<> struct hasBlock<DebyeHuckel> : std::true_type {};
+    template<> struct hasBlock<LennardJones> : std::true_type {};
+    template<class T> struct hasBlock<LennardJonesMixed<T>> : std::true_type {};
+    template<class T1, class T2> struct hasBlock<CombinedPairPotential<T1,T2>>
+      : std::integral_constant<bool, hasBlock<T1>::value && hasBlock<T2>::value> {};
+
     /**
      * @brief Lennard-Jones potential with Lorentz-Berthelot mixing rule
      */
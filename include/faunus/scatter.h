@@ -3,6 +3,7 @@
 
 #include <faunus/common.h>
 #include <faunus/inputfile.h>
+#include <faunus/geometry.h>
 
 namespace Faunus
 {
@@ -168,8 +169,23 @@ namespace Faunus
  *
  * - `qmin` Minimum q value (1/angstrom)
  * - `qmax` Maximum q value (1/angstrom)
- * - `dr` q spacing (1/angstrom)
+ * - `dq` q spacing (1/angstrom)
  * - `cutoff` Cutoff distance (angstrom). *Experimental!*
+ * - `histogram` Bin pair distances before transforming to I(q) (default: false)
+ * - `rbin` Distance resolution of the pair histogram (default: 0.01 angstrom)
+ *
+ * In histogram mode, `sample()` first bins all pair distances for each pair
+ * of particle types and then transforms the histogram to I(q) in a single
+ * pass over the q values. This reduces the cost from
+ * @f$\mathcal{O}(N^2 N_q)@f$ to @f$\mathcal{O}(N^2 + N_{bin} N_q)@f$ at the
+ * price of a distance error of at most `rbin/2`. Pairs are binned on all
+ * OpenMP threads and, with a finite `cutoff`, only neighbouring cells of a
+ * `Geometry::CellList` are visited. As in the pairwise sum, distances are
+ * calculated by the geometry so that a periodic `Geometry::Cuboid`, given
+ * to the constructor, gives minimum image distances; the cells then follow
+ * its boundaries. Form factors must then depend on the
+ * particle type (`id`) only, and the results are stored in the dense
+ * arrays `Ihist` and `Shist` rather than in `I` and `S`.
  *
  * See also <http://dx.doi.org/10.1016/S0022-2860(96)09302-7>
  */
@@ -177,22 +193,197 @@ namespace Faunus
     class DebyeFormula
     {
     private:
-        T qmin, qmax, dq, rc;
-    protected:
-        Tformfactor F; // scattering from a single particle
-        Tgeometry geo; // geometry to use for distance calculations
-    public:
-        std::map<T, T> I; //!< Sampled, average I(q)
-        std::map<T, T> S; //!< Weighted number of samplings
+        T qmin, qmax, dq, rc, rbin;
+        bool histogram;
+
+        // particle type used to look up form factors; points have a single type
+        template<class Tparticle>
+        static auto typeOf( const Tparticle &a, int ) -> decltype(int(a.id)) { return a.id; }
+
+        template<class Tparticle>
+        static int typeOf( const Tparticle &, long ) { return 0; }
+
+        /** @brief Number of q values in the `qmin`, `qmax`, `dq` grid */
+        int numQ() const { return int((qmax - qmin) / dq + 0.5) + 1; }
 
-        DebyeFormula( Tmjson &j ) : geo(10) {
+        void init( Tmjson &j )
+        {
             dq = j.at("dq");
             qmin = j.at("qmin");
             qmax = j.at("qmax");
             rc = j.value("cutoff", 1.0e9);
+            histogram = j.value("histogram", false);
+            rbin = j.value("rbin", 0.01);
 
             if (dq<=0 || qmin<=0 || qmax<=0 || qmin>qmax)
                 throw std::runtime_error("DebyeFormula: invalid q parameters");
+            if (rbin<=0)
+                throw std::runtime_error("DebyeFormula: rbin must be positive");
+        }
+
+        // cuboids: cells span the box and follow its periodicity
+        void setCells( Geometry::CellList &cells, const Point &, std::true_type )
+        {
+            cells.setGeometry(geo, rc);
+        }
+
+        // other geometries: non-periodic cells spanning all particles
+        void setCells( Geometry::CellList &cells, const Point &span, std::false_type )
+        {
+            Geometry::CuboidNoPBC box;
+            box.setlen(span.cwiseMax(Point(rc, rc, rc)) + Point(1, 1, 1));
+            cells.setGeometry(box, rc);
+        }
+
+    protected:
+        Tformfactor F; // scattering from a single particle
+        Tgeometry geo; // geometry to use for distance calculations
+    public:
+        std::map<T, T> I; //!< Sampled, average I(q)
+        std::map<T, T> S; //!< Weighted number of samplings
+
+        std::vector<double> Ihist; //!< Sampled I(q) in histogram mode (index: q bin)
+        std::vector<double> Shist; //!< Weighted number of samplings in histogram mode
+
+        DebyeFormula( Tmjson &j ) : geo(10) { init(j); }
+
+        /** @brief Construct with geometry used for distance calculations */
+        DebyeFormula( Tmjson &j, const Tgeometry &g ) : geo(g) { init(j); }
+
+        /** @brief q value of i'th bin in histogram mode */
+        T q( int i ) const { return qmin + i * dq; }
+
+        /**
+         * @brief Sample I(q) via a histogram of pair distances and add to average
+         *
+         * Used by `sample()` when `histogram` is set in the input.
+         *
+         * @param p Particle or point vector
+         * @param f weight of sampled configuration in biased simulations
+         * @param V Simulation volume (angstrom^3) used only for cut-off correction
+         */
+        template<class Tpvec>
+        void
+        sampleHistogram( const Tpvec &p, T f = 1, T V = -1 )
+        {
+            typedef typename Tpvec::value_type Tparticle;
+            typedef std::is_base_of<Geometry::Cuboid, Tgeometry> cuboid;
+            int N = (int) p.size();
+            if ( N == 0 )
+                return;
+
+            // compact type index and one representative particle per type
+            std::vector<int> compact, type(N), count;
+            std::vector<Tparticle> rep;
+            for ( int i = 0; i < N; i++ )
+            {
+                int id = typeOf(p[i], 0);
+                if ( id >= (int) compact.size())
+                    compact.resize(id + 1, -1);
+                if ( compact[id] < 0 )
+                {
+                    compact[id] = rep.size();
+                    rep.push_back(p[i]);
+                    count.push_back(0);
+                }
+                type[i] = compact[id];
+                count[type[i]]++;
+            }
+            int nt = rep.size();
+
+            // positions relative to the bounding box center, unless in a cuboid
+            Point lo = p[0], hi = p[0];
+            for ( auto &a : p )
+            {
+                lo = lo.cwiseMin(Point(a));
+                hi = hi.cwiseMax(Point(a));
+            }
+            Point span = hi - lo;
+            Point center = cuboid::value ? Point(0, 0, 0) : Point(0.5 * (lo + hi));
+            std::vector<Point> r(N);
+            for ( int i = 0; i < N; i++ )
+                r[i] = Point(p[i]) - center;
+
+            double rmax = std::min(double(rc), span.norm());
+            int nbin = int(rmax / rbin) + 1;
+            std::vector<double> H(nt * nt * nbin, 0); // pair histogram (index: type, type, bin)
+
+            // a cell list pays off only with a cutoff and enough particles per cell;
+            // cells do not wrap along the axis of a periodic cylinder
+            bool usecells = (rc < 1e9) && !std::is_base_of<Geometry::PeriodicCylinder, Tgeometry>::value;
+            Geometry::CellList cells;
+            if ( usecells )
+            {
+                setCells(cells, span, cuboid());
+                usecells = (cells.numCells() > 1 && int(cells.numCells()) <= N);
+            }
+            if ( usecells )
+                cells.build(r);
+
+#pragma omp parallel
+            {
+                std::vector<double> h(H.size(), 0);
+                auto bin = [&]( int i, int j ) {
+                    double r2 = geo.sqdist(r[i], r[j]);
+                    if ( r2 < rc * rc )
+                    {
+                        int a = std::min(type[i], type[j]), b = std::max(type[i], type[j]);
+                        int k = std::min(int(std::sqrt(r2) / rbin), nbin - 1);
+                        h[(a * nt + b) * nbin + k] += 1;
+                    }
+                };
+#pragma omp for schedule(dynamic, 64)
+                for ( int i = 0; i < N - 1; ++i )
+                {
+                    if ( usecells )
+                        cells.forNeighbours(r[i], [&]( int j ) { if ( j > i ) bin(i, j); });
+                    else
+                        for ( int j = i + 1; j < N; ++j )
+                            bin(i, j);
+                }
+#pragma omp critical
+                for ( size_t k = 0; k < H.size(); k++ )
+                    H[k] += h[k];
+            }
+
+            // form factors are evaluated serially as they may have state
+            int nq = numQ();
+            std::vector<double> Fq(nq * nt);
+            for ( int iq = 0; iq < nq; iq++ )
+                for ( int a = 0; a < nt; a++ )
+                    Fq[iq * nt + a] = F(q(iq), rep[a]);
+
+            Ihist.resize(nq, 0);
+            Shist.resize(nq, 0);
+
+#pragma omp parallel for schedule(static)
+            for ( int iq = 0; iq < nq; iq++ )
+            {
+                double _q = q(iq), _I = 0, _ff = 0;
+                const double *Fa = &Fq[iq * nt];
+                for ( int a = 0; a < nt; a++ )
+                {
+                    _ff += count[a] * Fa[a] * Fa[a];
+                    for ( int b = a; b < nt; b++ )
+                    {
+                        const double *h = &H[(a * nt + b) * nbin];
+                        double sum = 0;
+                        for ( int k = 0; k < nbin; k++ )
+                            if ( h[k] > 0 )
+                            {
+                                double qr = _q * (k + 0.5) * rbin;
+                                sum += h[k] * std::sin(qr) / qr;
+                            }
+                        _I += Fa[a] * Fa[b] * sum;
+                    }
+                }
+                double Icorr = 0;
+                if ( rc < 1e9 && V > 0 )
+                    Icorr = 4 * pc::pi * N / (V * pow(_q, 3)) *
+                        (_q * rc * cos(_q * rc) - sin(_q * rc));
+                Shist[iq] += f;
+                Ihist[iq] += ((2 * _I + _ff) / N + Icorr) * f; // add to average I(q)
+            }
         }
 
         /**
@@ -212,7 +403,10 @@ namespace Faunus
         sample( const Tpvec &p, T f = 1, T V = -1 )
         {
             assert(qmin > 0 && qmax > 0 && dq > 0 && "q range invalid.");
-            sample(p, qmin, qmax, dq, f, V);
+            if ( histogram )
+                sampleHistogram(p, f, V);
+            else
+                sample(p, qmin, qmax, dq, f, V);
         }
 
         /**
@@ -316,7 +510,15 @@ namespace Faunus
         void
         save( const string &filename )
         {
-            if ( !I.empty())
+            if ( !Ihist.empty())
+            {
+                std::ofstream f(filename.c_str());
+                if ( f )
+                    for ( size_t i = 0; i < Ihist.size(); i++ )
+                        if ( Shist[i] > 0 )
+                            f << q(i) << " " << Ihist[i] / Shist[i] << "\n";
+            }
+            else if ( !I.empty())
             {
                 std::ofstream f(filename.c_str());
                 if ( f )
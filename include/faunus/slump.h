@@ -62,7 +62,10 @@ namespace Faunus
       int range( int min, int max )
       {
           std::uniform_int_distribution<int> d(min, max);
-          return d(eng);
+          int x;
+#pragma omp critical
+          x = d(eng);
+          return x;
       }
 
       /** @brief Seed random number engine (s>0: deterministic, s=0 non-deterministic) */
@@ -205,6 +205,116 @@ namespace Faunus
 
   };
 
+  /**
+   * @brief Structure-of-arrays mirror of a particle vector
+   *
+   * Positions, charges, radii and atom ids are stored in separate
+   * contiguous arrays so that pair loops stream through memory
+   * without dragging along the remaining particle properties.
+   * The mirror is maintained by `Space` when enabled with
+   * `Space::enableArrays()`.
+   */
+  struct ParticleArrays
+  {
+      std::vector<double> x, y, z, charge, radius;
+      std::vector<int> id;
+
+      size_t size() const { return x.size(); }
+
+      void resize( size_t n )
+      {
+          x.resize(n);
+          y.resize(n);
+          z.resize(n);
+          charge.resize(n);
+          radius.resize(n);
+          id.resize(n);
+      }
+
+      /** @brief Copy properties of particle `a` into i'th element */
+      template<class Tparticle>
+      inline void set( int i, const Tparticle &a )
+      {
+          x[i] = a.x();
+          y[i] = a.y();
+          z[i] = a.z();
+          charge[i] = a.charge;
+          radius[i] = a.radius;
+          id[i] = a.id;
+      }
+
+      /** @brief Copy all particles in vector */
+      template<class Tpvec>
+      void assign( const Tpvec &p )
+      {
+          resize(p.size());
+          for ( size_t i = 0; i < p.size(); i++ )
+              set(i, p[i]);
+      }
+  };
+
+  /**
+   * @brief Sparse record of trial particles that differ from the main vector
+   *
+   * Moves mark the particle indices they modify in `Space::trial` and
+   * `Space::acceptTrial()` or `Space::rejectTrial()` then copy only those
+   * particles, i.e. O(k) for k touched particles rather than O(N).
+   * Marking is idempotent; if everything is marked with `touchAll()`
+   * the whole vector is copied.
+   */
+  class TrialIndex
+  {
+  private:
+      std::vector<char> flag; // flag[i]!=0 if i is in `index`
+      std::vector<int> index; // touched indices in order of first touch
+      bool all;
+
+  public:
+      TrialIndex() : all(false) {}
+
+      /** @brief Mark particle `i` as modified */
+      inline void touch( int i )
+      {
+          assert(i >= 0);
+          if ( all )
+              return;
+          if ( (size_t) i >= flag.size())
+              flag.resize(i + 1, 0);
+          if ( !flag[i] )
+          {
+              flag[i] = 1;
+              index.push_back(i);
+          }
+      }
+
+      /** @brief Mark all particles as modified */
+      void touchAll() { all = true; }
+
+      /** @brief True if all particles are marked */
+      bool isAll() const { return all; }
+
+      /** @brief True if no particles are marked */
+      bool empty() const { return !all && index.empty(); }
+
+      /** @brief True if particle `i` is marked */
+      bool contains( int i ) const
+      {
+          return all || ((size_t) i < flag.size() && flag[i]);
+      }
+
+      /** @brief Marked indices (undefined content if `isAll()`) */
+      const std::vector<int> &indices() const { return index; }
+
+      /** @brief Unmark all in O(k) */
+      void clear()
+      {
+          for ( auto i : index )
+              flag[i] = 0;
+          index.clear();
+          all = false;
+      }
+  };
+
   /**
    * @brief Placeholder for particles and groups
    *
@@ -242,8 +352,21 @@ namespace Faunus
   private:
       bool checkSanity();                    //!< Check group length and vector sync
       std::vector<Group *> g;                 //!< Pointers to ALL groups in the system
+      bool arrays;                           //!< True if `soa` and `soa_trial` are maintained
+      TrialIndex touched;                    //!< Trial particles pending accept/reject
+      std::vector<int> groupIndex;           //!< Index in `g` for each particle (-1 if none)
+      size_t groupIndexSize;                 //!< Number of groups when `groupIndex` was built
+      bool groupIndexStale;                  //!< True if `groupIndex` must be rebuilt
+      unsigned long layout;                  //!< Incremented whenever particle indices may shift
       Tmjson to_json();
 
+      /** @brief Invalidate index lookups after insertion or removal */
+      void indicesChanged()
+      {
+          groupIndexStale = true;
+          layout++;
+      }
+
   public:
       typedef std::vector<Tparticle, Eigen::aligned_allocator<Tparticle> > p_vec;
       typedef p_vec ParticleVector;          //!< Particle vector type
@@ -258,6 +381,8 @@ namespace Faunus
       ParticleVector p;                      //!< Main particle vector
       ParticleVector trial;                  //!< Trial particle vector.
       MoleculeMap<ParticleVector> molecule;  //!< Map of molecules
+      ParticleArrays soa;                    //!< Structure-of-arrays mirror of `p` (if enabled)
+      ParticleArrays soa_trial;              //!< Structure-of-arrays mirror of `trial` (if enabled)
 
       Tracker<int> atomTrack;                //!< Track atom index based on atom type
       Tracker<Group *> molTrack;              //!< Track groups pointers based on molecule type
@@ -280,7 +405,7 @@ namespace Faunus
           std::map<int, vector<int>> rmGroup; // remove groups
           std::map<int, ParticleVector> inGroup; // insert groups
 
-          Change() : dV(0) {};
+          Change() : dV(0), geometryChange(false) {};
 
           void clear()
           {
@@ -338,7 +463,7 @@ namespace Faunus
        * is searched for molecules with non-zero `Ninit` and
        * will insert accordingly.
        */
-      Space( Tmjson &j ) try : geo( j.at("system").at("geometry") )
+      Space( Tmjson &j ) try : arrays(false), groupIndexSize(0), groupIndexStale(true), layout(0), geo( j.at("system").at("geometry") )
       {
           pc::setT( j.at("system").value("temperature", 298.15) );
           atom.include( j.at("atomlist") );
@@ -353,6 +478,17 @@ namespace Faunus
           throw;
       }
 
+      /**
+       * @brief Construct empty space with given geometry and molecule types
+       *
+       * Unlike the JSON constructor, global data such as `atom` and the
+       * temperature are left untouched, making this suitable for private
+       * copies that are later filled using `restore()`.
+       */
+      Space( const Tgeometry &geometry, const MoleculeMap<ParticleVector> &molecules ) :
+          arrays(false), groupIndexSize(0), groupIndexStale(true), layout(0),
+          geo(geometry), geo_trial(geometry), molecule(molecules) {}
+
       std::vector<Group *> &groupList() { return g; };   //!< Vector with pointers to all groups
 
       AtomMap &atomList() { return atom; } //!< Vector of atoms
@@ -371,11 +507,109 @@ namespace Faunus
       void reserve( int );           //!< Reserve space for particles for better memory efficiency
       string info();               //!< Information string
 
+      /**
+       * @brief Maintain structure-of-arrays mirrors, `soa` and `soa_trial`
+       *
+       * Once enabled, the mirrors are updated by `syncArrays()` which
+       * is called by `Move::Movebase` after each trial move as well
+       * as after acceptance or rejection, and by `load()`, `insert()`,
+       * `erase()` and `eraseGroup()`. Code that modifies `p` or `trial`
+       * directly must call `syncArrays()` itself.
+       */
+      void enableArrays()
+      {
+          arrays = true;
+          syncArrays();
+      }
+
+      bool arraysEnabled() const { return arrays; } //!< True if array mirrors are maintained
+
+      /**
+       * @brief Counter that changes whenever particles or groups are inserted or erased
+       *
+       * Lets energy terms that cache particle indices detect that these
+       * may have shifted, see `Energy::Bonded`.
+       */
+      unsigned long layoutCount() const { return layout; }
+
+      /** @brief Mark trial particle `i` as modified, see `TrialIndex` */
+      void touch( int i ) { touched.touch(i); }
+
+      /** @brief Mark all trial particles as modified */
+      void touchAll() { touched.touchAll(); }
+
+      /** @brief Copy marked particles from `trial` to `p` and clear marks */
+      void acceptTrial()
+      {
+          if ( touched.isAll())
+              p = trial;
+          else
+              for ( auto i : touched.indices())
+                  p[i] = trial[i];
+          touched.clear();
+      }
+
+      /** @brief Restore marked particles in `trial` from `p` and clear marks */
+      void rejectTrial()
+      {
+          if ( touched.isAll())
+              trial = p;
+          else
+              for ( auto i : touched.indices())
+                  trial[i] = p[i];
+          touched.clear();
+      }
+
+      /** @brief Marked trial particles */
+      const TrialIndex &touchedTrial() const { return touched; }
+
+      /** @brief Copy `p` and `trial` into array mirrors */
+      void syncArrays()
+      {
+          if ( arrays )
+          {
+              soa.assign(p);
+              soa_trial.assign(trial);
+          }
+      }
+
+      /**
+       * @brief Update array mirrors for particles touched by a change
+       *
+       * Volume moves, insertions, deletions as well as empty
+       * changes trigger a full update.
+       */
+      void syncArrays( const Change &c )
+      {
+          if ( !arrays )
+              return;
+          if ( c.empty() || c.geometryChange || !c.rmGroup.empty() || !c.inGroup.empty()
+              || soa.size() != p.size() || soa_trial.size() != trial.size())
+              return syncArrays();
+          for ( auto &m : c.mvGroup )
+          {
+              auto grp = g.at(m.first);
+              if ( m.second.empty())
+                  for ( auto i : *grp )
+                  {
+                      soa.set(i, p[i]);
+                      soa_trial.set(i, trial[i]);
+                  }
+              else
+                  for ( auto i : m.second )
+                  {
+                      soa.set(i, p[i]);
+                      soa_trial.set(i, trial[i]);
+                  }
+          }
+      }
+
       /** @brief Reset and refill atom- and molecular trackers*/
       inline void initTracker()
       {
           atomTrack.clear();
           molTrack.clear();
+          indicesChanged();
           for ( auto g : groupList())
           {
               assert((size_t) g->front() < p.size()
@@ -387,16 +621,97 @@ namespace Faunus
           }
       }
 
+      /** @brief Copy of the state needed to analyse a configuration (see `snapshot()`) */
+      struct Snapshot
+      {
+          ParticleVector p;          //!< Particles (positions, charges etc.)
+          Tgeometry geo;             //!< Geometry incl. volume
+          std::vector<Group> groups; //!< Group ranges and mass centers
+      };
+
+      /** @brief Store particles, geometry and groups in `s`, reusing its memory */
+      void snapshot( Snapshot &s ) const
+      {
+          s.p = p;
+          s.geo = geo;
+          s.groups.resize(g.size());
+          for ( size_t i = 0; i < g.size(); i++ )
+              s.groups[i] = *g[i];
+      }
+
+      /**
+       * @brief Restore state from snapshot
+       *
+       * Groups are re-created and trackers updated only if the number of
+       * particles or the group layout differs from the current one. The
+       * trial vector and geometry are set equal to the restored ones.
+       */
+      void restore( const Snapshot &s )
+      {
+          bool changed = (s.p.size() != p.size() || s.groups.size() != g.size());
+          for ( size_t i = 0; i < g.size() && !changed; i++ )
+              changed = (g[i]->front() != s.groups[i].front() || g[i]->back() != s.groups[i].back()
+                  || g[i]->molId != s.groups[i].molId);
+          p = s.p;
+          trial = s.p;
+          geo = geo_trial = s.geo;
+          if ( changed )
+          {
+              for ( auto i : g )
+                  delete i;
+              g.clear();
+              for ( auto &i : s.groups )
+                  g.push_back(new Group(i));
+              initTracker();
+          }
+          else
+              for ( size_t i = 0; i < g.size(); i++ )
+                  *g[i] = s.groups[i];
+          syncArrays();
+      }
+
+      /**
+       * @brief Rebuild particle-to-group lookup used by `findGroup()`
+       *
+       * Called automatically when particles or groups are inserted or
+       * erased through `Space`. If particles are in several groups, the
+       * first one in `groupList()` is stored.
+       */
+      void updateGroupIndex()
+      {
+          groupIndex.assign(p.size(), -1);
+          for ( int k = (int) g.size() - 1; k >= 0; k-- )
+              for ( auto i : *g[k] )
+                  if ( i >= 0 && i < (int) groupIndex.size())
+                      groupIndex[i] = k;
+          groupIndexSize = g.size();
+          groupIndexStale = false;
+      }
+
       /**
        * @brief Find which group given particle index belongs to.
        *
+       * The lookup is constant time and is verified against the group
+       * range; should groups have been modified behind the back of
+       * `Space`, the lookup table is rebuilt.
        * If not found, `nullptr` is returned.
        */
       inline Group *findGroup( int i )
       {
-          for ( auto g : groupList())
-              if ( g->find(i))
-                  return g;
+          if ( i < 0 || i >= (int) p.size())
+              return nullptr;
+          if ( groupIndexStale || groupIndex.size() != p.size() || groupIndexSize != g.size())
+              updateGroupIndex();
+          int k = groupIndex[i];
+          if ( k >= 0 && k < (int) g.size() && g[k]->find(i))
+              return g[k];
+          if ( k >= 0 )
+          { // stale entry
+              updateGroupIndex();
+              k = groupIndex[i];
+              if ( k >= 0 )
+                  return g[k];
+          }
           return nullptr;
       }
 
@@ -407,6 +722,14 @@ namespace Faunus
        */
       inline int findIndex( Group *group )
       {
+          if ( group != nullptr && !group->empty())
+          {
+              int k = -1, i = group->front();
+              if ( !groupIndexStale && i >= 0 && i < (int) groupIndex.size())
+                  k = groupIndex[i];
+              if ( k >= 0 && k < (int) g.size() && g[k] == group )
+                  return k;
+          }
           auto it = std::find(g.begin(), g.end(), group);
           return (it != g.end()) ? it - g.begin() : -1;
       }
@@ -574,6 +897,8 @@ namespace Faunus
   template<class Tgeometry, class Tparticle>
   bool Space<Tgeometry, Tparticle>::insert( const Tparticle &a, int i )
   {
+      assert(touched.empty() && "Insertion with pending trial particles");
+      indicesChanged();
       if ( i == -1 || i > (int) p.size())
       {
           i = p.size();
@@ -594,6 +919,7 @@ namespace Faunus
           if ( gj->back() >= i )
               gj->setback(gj->back() + 1);    //gj->last++; // +1 is a special case for adding to the end of p-vector
       }
+      syncArrays();
       return true;
   }
 
@@ -601,6 +927,8 @@ namespace Faunus
   template<class Tgeometry, class Tparticle>
   bool Space<Tgeometry, Tparticle>::erase( int i )
   {
+      assert(touched.empty() && "Deletion with pending trial particles");
+      indicesChanged();
       assert(i < (int) p.size());
 
       if ( i < (int) p.size())
@@ -626,6 +954,7 @@ namespace Faunus
               g.erase(g.begin() + findIndex(is_empty));
               delete (is_empty);
           }
+          syncArrays();
           return true;
       }
       return false;
@@ -645,6 +974,7 @@ namespace Faunus
 
       assert(!groupList().empty());
       assert(i >= 0 && i < (int) g.size());
+      indicesChanged();
       assert(atomTrack.size() == p.size());
 
       if ( !groupList().empty())
@@ -684,6 +1014,7 @@ namespace Faunus
               }
 
           assert(atomTrack.size() == p.size());
+          syncArrays();
           return true;
       }
       return false;
@@ -828,6 +1159,7 @@ namespace Faunus
               }
 
               initTracker(); // update trackers
+              syncArrays();
 
               checkSanity();
 
@@ -906,7 +1238,7 @@ namespace Faunus
   {
       if ( !pin.empty())
       {
-
+          indicesChanged();
           assert(atomTrack.size() == p.size());
 
           // insert atomic groups into existing group, if present
@@ -948,6 +1280,7 @@ namespace Faunus
                       atomTrack.insert(p[i].id, i);
 
                   assert(atomTrack.size() == p.size());
+                  syncArrays();
 
                   return g[imax];
               }
@@ -977,6 +1310,7 @@ namespace Faunus
               x->setMolSize(pin.size());
 
           x->setMassCenter(*this);
+          syncArrays();
 
           return x;
       }
@@ -9,9 +9,18 @@
 #include <vector>
 #include <functional>
 #include <map>
+#include <set>
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <typeinfo>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <faunus/potentials.h>
 
@@ -122,6 +131,16 @@ namespace Faunus
             numdr = 0.0001; // dr for derivative evaluation                    
         }
 
+        /** @brief Range and tolerances in full precision, e.g. for cache keys */
+        std::string signature() const
+        {
+            std::ostringstream o;
+            o.precision(17);
+            o << rmin << " " << rmax << " " << utol << " " << ftol << " "
+              << umaxtol << " " << fmaxtol << " " << numdr;
+            return o.str();
+        }
+
         std::string info( char w = 20 )
         {
             using namespace Faunus::textio;
@@ -1249,6 +1268,354 @@ namespace Faunus
         }
     };
 
+    /**
+     * @brief Allocator returning memory aligned to `N` bytes (default: a cache line)
+     */
+    template<typename T, size_t N=64>
+    struct CacheAlignedAllocator
+    {
+        typedef T value_type;
+
+        template<typename U>
+        struct rebind
+        {
+            typedef CacheAlignedAllocator<U, N> other;
+        };
+
+        CacheAlignedAllocator() {}
+
+        template<typename U>
+        CacheAlignedAllocator( const CacheAlignedAllocator<U, N> & ) {}
+
+        T *allocate( size_t n )
+        {
+            void *ptr = nullptr;
+            if ( posix_memalign(&ptr, N, n * sizeof(T)) != 0 )
+                throw std::bad_alloc();
+            return static_cast<T *>(ptr);
+        }
+
+        void deallocate( T *ptr, size_t ) { free(ptr); }
+
+        template<typename U>
+        bool operator==( const CacheAlignedAllocator<U, N> & ) const { return true; }
+
+        template<typename U>
+        bool operator!=( const CacheAlignedAllocator<U, N> & ) const { return false; }
+    };
+
+    /**
+     * @brief Quintic splines on a uniform grid in r2
+     *
+     * Uses the same interpolating polynomials as `Andrea`, but all intervals
+     * are of equal width in r2 so that the interval holding a given distance
+     * is found in constant time rather than by a logarithmic search.
+     * The number of intervals is doubled until the tolerances are met.
+     * If `umaxtol` is set, the lower bound is moved outwards until the
+     * magnitude of the function drops below `umaxtol`.
+     *
+     * In the generated table, `r2` holds the interval boundaries while `c`
+     * holds six coefficients, padded to `stride`, for each interval so that an
+     * interval fits a single 64 byte cache line if the table is aligned.
+     */
+    template<typename T=double>
+    class Uniform : public TabulatorBase<T>
+    {
+    private:
+        typedef TabulatorBase<T> base; // for convenience
+        int ncheck;   // Number of points to check in each interval
+        int maxgrid;  // Max number of intervals
+
+        /** @brief Polynomial coefficients from value, first and second derivative at both ends */
+        static void coefficients( T dz, const T *low, const T *upp, T *c )
+        {
+            T dz2 = dz * dz;
+            T dz3 = dz2 * dz;
+            c[0] = low[0];
+            c[1] = low[1];
+            c[2] = low[2] * 0.5;
+            T a = 6 * (upp[0] - c[0] - c[1] * dz - c[2] * dz2) / dz3;
+            T b = 2 * (upp[1] - c[1] - 2 * c[2] * dz) / dz2;
+            T cc = (upp[2] - 2 * c[2]) / dz;
+            c[3] = (10 * a - 12 * b + 3 * cc) / 6;
+            c[4] = (-15 * a + 21 * b - 6 * cc) / (6 * dz);
+            c[5] = (2 * a - 3 * b + cc) / (2 * dz2);
+        }
+
+    public:
+        enum { stride = 8 }; //!< Number of coefficients per interval, including padding
+
+        Uniform() : base()
+        {
+            ncheck = 11;
+            maxgrid = 1 << 18;
+        }
+
+        /** @brief Value of interval `c` at distance `dz` from its lower boundary */
+        static inline T polynomial( const T *c, T dz )
+        {
+            return c[0] + dz * (c[1] + dz * (c[2] + dz * (c[3] + dz * (c[4] + dz * c[5]))));
+        }
+
+        /** @brief Derivative of interval `c` at distance `dz` from its lower boundary */
+        static inline T derivative( const T *c, T dz )
+        {
+            return c[1] + dz * (2 * c[2] + dz * (3 * c[3] + dz * (4 * c[4] + dz * 5 * c[5])));
+        }
+
+        /**
+         * @brief Get tabulated value at f(x)
+         * @param d Table data
+         * @param r2 x value
+         */
+        T eval( const typename base::data &d, T r2 ) const
+        {
+            int n = int(d.r2.size()) - 1;
+            int i = int((r2 - d.rmin2) * n / (d.rmax2 - d.rmin2));
+            i = std::max(0, std::min(i, n - 1));
+            return polynomial(&d.c[i * stride], r2 - d.r2[i]);
+        }
+
+        /**
+         * @brief Tabulate f(x)
+         */
+        typename base::data generate( std::function<T( T )> f )
+        {
+            base::check();
+            typename base::data td;
+            T rmin = base::rmin;
+            if ( base::umaxtol != -1 )
+            {
+                T dr = (base::rmax - base::rmin) / 1000;
+                while ( rmin + dr < base::rmax && std::fabs(f(rmin * rmin)) > base::umaxtol )
+                    rmin += dr;
+            }
+            td.rmin2 = rmin * rmin;
+            td.rmax2 = base::rmax * base::rmax;
+
+            for ( int n = 16; n <= maxgrid; n *= 2 )
+            {
+                T dz = (td.rmax2 - td.rmin2) / n;
+                std::vector<T> u(3 * (n + 1)); // value and derivatives at interval boundaries
+                for ( int i = 0; i <= n; i++ )
+                {
+                    T z = td.rmin2 + i * dz;
+                    u[3 * i] = f(z);
+                    u[3 * i + 1] = base::f1(f, z);
+                    u[3 * i + 2] = base::f2(f, z);
+                }
+                td.c.assign(n * stride, 0);
+                bool ok = true;
+                for ( int i = 0; i < n && ok; i++ )
+                {
+                    T *c = &td.c[i * stride];
+                    coefficients(dz, &u[3 * i], &u[3 * i + 3], c);
+                    for ( int k = 1; k < ncheck - 1 && ok; k++ )
+                    {
+                        T ddz = dz * k / (ncheck - 1);
+                        T z = td.rmin2 + i * dz + ddz;
+                        if ( std::fabs(polynomial(c, ddz) - f(z)) > base::utol )
+                            ok = false;
+                        else if ( base::ftol != -1 && std::fabs(derivative(c, ddz) - base::f1(f, z)) > base::ftol )
+                            ok = false;
+                    }
+                }
+                if ( ok )
+                {
+                    td.r2.resize(n + 1);
+                    for ( int i = 0; i <= n; i++ )
+                        td.r2[i] = td.rmin2 + i * dz;
+                    return td;
+                }
+            }
+            throw std::runtime_error("Uniform spline: try to increase utol/ftol or rmin");
+        }
+    };
+
+    /**
+     * @brief Binary on-disk cache of generated tables
+     *
+     * If the environment variable `FAUNUS_TABCACHE` is set to a directory,
+     * generated tables are stored there and reused by later runs. Files are
+     * named after a hash of a key that must describe the tabulated function
+     * and its parameters; `generate()` appends the tabulator type, range
+     * and tolerances. Caching is disabled if the variable is unset.
+     *
+     * Cached files are memory mapped read-only so that concurrent runs,
+     * e.g. MPI replicas, share a single copy of the tables. Files are written
+     * under a temporary name and renamed so that readers never see partial
+     * tables, and the full key is stored and compared on load.
+     *
+     * Layout: magic, key length, number of blocks, the key, block sizes and
+     * finally the blocks of doubles, each starting on a 64 byte boundary.
+     */
+    class TableCache
+    {
+    public:
+        /** @brief Read-only memory map of a file */
+        class Map
+        {
+        private:
+            void *ptr;
+            size_t len;
+
+        public:
+            Map( const std::string &file ) : ptr(MAP_FAILED), len(0)
+            {
+                int fd = open(file.c_str(), O_RDONLY);
+                if ( fd < 0 )
+                    return;
+                struct stat st;
+                if ( fstat(fd, &st) == 0 && st.st_size > 0 )
+                {
+                    len = st.st_size;
+                    ptr = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+                }
+                close(fd);
+            }
+
+            ~Map()
+            {
+                if ( ptr != MAP_FAILED )
+                    munmap(ptr, len);
+            }
+
+            Map( const Map & ) = delete;
+            Map &operator=( const Map & ) = delete;
+
+            bool good() const { return ptr != MAP_FAILED; }
+            const char *data() const { return static_cast<const char *>(ptr); }
+            size_t size() const { return len; }
+        };
+
+        typedef std::vector<std::pair<const double *, size_t> > Tblocks; // pointer and size of blocks
+
+    private:
+        enum { align = 64 };
+
+        static uint64_t hash( const std::string &s )
+        {
+            uint64_t h = 14695981039346656037ull; // FNV-1a
+            for ( unsigned char c : s )
+                h = (h ^ c) * 1099511628211ull;
+            return h;
+        }
+
+        static size_t padded( size_t bytes ) { return (bytes + align - 1) / align * align; }
+
+    public:
+        /** @brief Cache directory; empty if caching is disabled */
+        static std::string directory()
+        {
+            const char *dir = std::getenv("FAUNUS_TABCACHE");
+            return (dir == nullptr) ? std::string() : std::string(dir);
+        }
+
+        static std::string filename( const std::string &key )
+        {
+            std::ostringstream o;
+            o << directory() << "/faunus-" << std::hex << hash(key) << ".tab";
+            return o.str();
+        }
+
+        /**
+         * @brief Map cached blocks for `key`
+         * @return Mapping that must be kept alive while `blocks` are in use; `nullptr` if not cached
+         */
+        static std::shared_ptr<const Map> load( const std::string &key, Tblocks &blocks )
+        {
+            blocks.clear();
+            if ( directory().empty())
+                return nullptr;
+            auto map = std::make_shared<const Map>(filename(key));
+            if ( !map->good() || map->size() < 24 || std::string(map->data(), 8) != "FAUTAB01" )
+                return nullptr;
+            uint64_t keylen, nblocks;
+            std::memcpy(&keylen, map->data() + 8, 8);
+            std::memcpy(&nblocks, map->data() + 16, 8);
+            size_t pos = 24 + keylen + 8 * nblocks;
+            if ( pos > map->size() || std::string(map->data() + 24, keylen) != key )
+                return nullptr;
+            pos = padded(pos);
+            for ( uint64_t i = 0; i < nblocks; i++ )
+            {
+                uint64_t n;
+                std::memcpy(&n, map->data() + 24 + keylen + 8 * i, 8);
+                if ( pos + n * sizeof(double) > map->size())
+                    return nullptr;
+                blocks.push_back({reinterpret_cast<const double *>(map->data() + pos), n});
+                pos = padded(pos + n * sizeof(double));
+            }
+            return map;
+        }
+
+        /** @brief Store blocks for `key`; returns false on failure */
+        static bool save( const std::string &key, const Tblocks &blocks )
+        {
+            if ( directory().empty())
+                return false;
+            std::string file = filename(key);
+            std::ostringstream tmp;
+            tmp << file << "." << getpid() << ".tmp";
+            std::ofstream f(tmp.str(), std::ios::binary);
+            if ( !f )
+                return false;
+            uint64_t keylen = key.size(), nblocks = blocks.size();
+            std::vector<char> zero(align, 0);
+            f.write("FAUTAB01", 8);
+            f.write(reinterpret_cast<const char *>(&keylen), 8);
+            f.write(reinterpret_cast<const char *>(&nblocks), 8);
+            f.write(key.data(), keylen);
+            size_t pos = 24 + keylen;
+            for ( auto &b : blocks )
+            {
+                uint64_t n = b.second;
+                f.write(reinterpret_cast<const char *>(&n), 8);
+                pos += 8;
+            }
+            for ( auto &b : blocks )
+            {
+                f.write(zero.data(), padded(pos) - pos);
+                pos = padded(pos);
+                f.write(reinterpret_cast<const char *>(b.first), b.second * sizeof(double));
+                pos += b.second * sizeof(double);
+            }
+            f.close();
+            if ( !f || std::rename(tmp.str().c_str(), file.c_str()) != 0 )
+            {
+                std::remove(tmp.str().c_str());
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Generate table of `f` with `tab` unless found in cache
+         * @param key Description of `f` including all parameters it depends on
+         */
+        template<class Ttabulator, class T=double>
+        static typename Ttabulator::data generate( Ttabulator &tab, const std::string &key, std::function<T( T )> f )
+        {
+            std::string fullkey = key + "|" + typeid(Ttabulator).name() + "|" + tab.signature();
+            typename Ttabulator::data d;
+            Tblocks b;
+            auto map = load(fullkey, b);
+            if ( map && b.size() == 3 && b[2].second == 2 )
+            {
+                d.r2.assign(b[0].first, b[0].first + b[0].second);
+                d.c.assign(b[1].first, b[1].first + b[1].second);
+                d.rmin2 = b[2].first[0];
+                d.rmax2 = b[2].first[1];
+                return d;
+            }
+            d = tab.generate(f);
+            std::vector<double> r2(d.r2.begin(), d.r2.end()), c(d.c.begin(), d.c.end());
+            double range[2] = {double(d.rmin2), double(d.rmax2)};
+            save(fullkey, {{r2.data(), r2.size()}, {c.data(), c.size()}, {range, 2}});
+            return d;
+        }
+    };
+
   } //Tabulate namespace
 
 #ifdef FAUNUS_POTENTIAL_H
@@ -1257,39 +1624,197 @@ namespace Faunus
   {
 
     /**
-     * @brief Tabulated potential between all particle types
+     * @brief Tabulated potential between particle types
+     *
+     * Splines for all pairs of atom types found in the system are generated
+     * by `setSpace()` using `Tabulate::Uniform` and the properties (charge,
+     * radius etc.) of the atom types. Types are taken from the particles and
+     * from the molecule types that may be inserted; should new types appear,
+     * the tables are regenerated. Pairs may also be tabulated explicitly with
+     * `tabulate()` and pairs not tabulated are evaluated by the original
+     * pair potential.
+     *
+     * Coefficients for all pairs are stored in one contiguous,
+     * cache line aligned array and a pair is found through a table indexed
+     * by the two particle types. Evaluation is thus a table lookup and an
+     * interval found by a single multiplication.
+     *
+     * Below `tab_rmin` the original pair potential is used while the potential
+     * is assumed to be zero beyond `tab_rmax`. Splines are stored in and mapped
+     * from the on-disk cache if enabled, see `Tabulate::TableCache`.
      */
-    template<typename Tpairpot, typename Ttabulator=Tabulate::Andrea<double> >
+    template<typename Tpairpot>
     class PotentialTabulate : public Tpairpot
     {
     private:
+        typedef Tabulate::Uniform<double> Ttabulator;
+        typedef std::vector<double, Tabulate::CacheAlignedAllocator<double>> Tarena;
+
+        struct Table
+        {
+            double rmin2, rmax2, dz, invdz;
+            size_t offset; // first coefficient in arena
+            int n;         // number of intervals
+        };
+
         Ttabulator tab;
-        typedef opair<int> Tpair;
-        std::map<Tpair, typename Ttabulator::data> m;
+        size_t ntypes;
+        std::vector<Table> tables;        // ntypes x ntypes; `n=0` if not tabulated
+        std::set<int> types;              // tabulated atom types
+        const double *arena;              // coefficients for all pairs
+        std::shared_ptr<const void> owner; // keeps arena alive; a vector or a mapped cache file
+        std::string input;                 // json input of the pair potential
+        std::vector<double> probe;         // r^2 values at which the potential is sampled for the key
+
+        /**
+         * @brief Cache key: pair potential input, atom properties and tabulation parameters
+         *
+         * As not all parameters are found in the input (temperature, mixing etc.), the
+         * key also contains the potential between each pair of atom types at a few distances.
+         */
+        std::string key()
+        {
+            std::ostringstream o;
+            o.precision(17);
+            o << "PotentialTabulate|" << typeid(Tpairpot).name() << "|" << input << "|" << tab.signature();
+            for ( auto &i : atom )
+                o << "|" << i.name << " " << i.charge << " " << i.sigma << " " << i.eps
+                  << " " << i.radius << " " << i.muscalar << " " << i.alphax;
+            o << "|types";
+            for ( auto i : types )
+                o << " " << i;
+            Tpairpot pot(*this);
+            for ( auto i : types )
+                for ( auto j : types )
+                    if ( j >= i )
+                    {
+                        PointParticle a, b;
+                        a = atom[i];
+                        b = atom[j];
+                        o << "|";
+                        for ( auto r2 : probe )
+                            o << " " << pot(a, b, r2);
+                    }
+            return o.str();
+        }
+
+        /** @brief Load splines from cache; returns false if not found */
+        bool load( const std::string &k )
+        {
+            Tabulate::TableCache::Tblocks b;
+            auto map = Tabulate::TableCache::load(k, b);
+            if ( !map || b.size() != 2 || b[0].second != 6 * ntypes * ntypes )
+                return false;
+            for ( size_t i = 0; i < tables.size(); i++ )
+            {
+                const double *h = b[0].first + 6 * i;
+                tables[i] = Table{h[0], h[1], h[2], h[3], size_t(h[4]), int(h[5])};
+            }
+            arena = b[1].first;
+            owner = map;
+            return true;
+        }
+
+        void save( const std::string &k, const Tarena &v )
+        {
+            std::vector<double> h;
+            for ( auto &t : tables )
+                h.insert(h.end(), {t.rmin2, t.rmax2, t.dz, t.invdz, double(t.offset), double(t.n)});
+            Tabulate::TableCache::save(k, {{h.data(), h.size()}, {v.data(), v.size()}});
+        }
 
     public:
         PotentialTabulate( Tmjson &j ) : Tpairpot(j)
         {
-            tab.setRange(
-                j["tab_rmin"] | 1.0,
-                j["tab_rmax"] | 100.0);
+            double rmin = j["tab_rmin"] | 1.0, rmax = j["tab_rmax"] | 100.0;
+            for ( int i = 0; i < 8; i++ ) // geometric spacing from rmin to rmax
+                probe.push_back(std::pow(rmin * std::pow(rmax / rmin, i / 7.0), 2));
+            tab.setRange(rmin, rmax);
             tab.setTolerance(
                 j["tab_utol"] | 0.01,
                 j["tab_ftol"] | -1.0,
                 j["tab_umaxtol"] | -1.0,
                 j["tab_fmaxtol"] | -1.0);
+            input = j.dump(); // after all lookups as these may add null entries
+            ntypes = 0;
+            arena = nullptr;
         }
 
+        /**
+         * @brief Generate splines for all pairs of the given atom types
+         *
+         * Tables of previously tabulated types not in `ids` are discarded.
+         * Throws if a spline for any of the pairs cannot be generated.
+         */
+        void tabulate( const std::set<int> &ids )
+        {
+            types = ids;
+            ntypes = atom.size();
+            tables.assign(ntypes * ntypes, Table{0, 0, 0, 0, 0, 0});
+            std::string k = key();
+            if ( load(k))
+                return;
+            auto v = std::make_shared<Tarena>();
+            for ( auto i : types )
+                for ( auto j : types )
+                    if ( j >= i )
+                    {
+                        PointParticle a, b;
+                        a = atom[i];
+                        b = atom[j];
+                        Tpairpot pot(*this);
+                        std::function<double( double )> f = [=]( double r2 ) mutable { return pot(a, b, r2); };
+                        auto d = tab.generate(f);
+                        Table t;
+                        t.n = int(d.r2.size()) - 1;
+                        t.rmin2 = d.rmin2;
+                        t.rmax2 = d.rmax2;
+                        t.dz = (d.rmax2 - d.rmin2) / t.n;
+                        t.invdz = 1 / t.dz;
+                        t.offset = v->size();
+                        v->insert(v->end(), d.c.begin(), d.c.end());
+                        tables[i * ntypes + j] = tables[j * ntypes + i] = t;
+                    }
+            save(k, *v);
+            arena = v->data();
+            owner = v;
+        }
+
+        /** @brief Tabulate atom types in `s.p` and in all molecule types, unless already done */
+        template<class Tspace>
+        void setSpace( Tspace &s )
+        {
+            Tpairpot::setSpace(s);
+            std::set<int> ids;
+            for ( auto &a : s.p )
+                ids.insert(a.id);
+            for ( auto &m : s.molecule )
+                ids.insert(m.atoms.begin(), m.atoms.end());
+            if ( ntypes != atom.size() || !std::includes(types.begin(), types.end(), ids.begin(), ids.end()))
+            {
+                ids.insert(types.begin(), types.end());
+                tabulate(ids);
+            }
+        }
+
+        /** @brief Tabulated atom types */
+        const std::set<int> &tabulated() const { return types; }
+
         template<class Tparticle>
         double operator()( const Tparticle &a, const Tparticle &b, double r2 )
         {
-            Tpair ab(a.id, b.id);
-            auto it = m.find(ab);
-            if ( it != m.end())
-                return tab.eval(it->second, r2);
-            std::function<double( double )> f = [=]( double r2 ) { return Tpairpot(*this)(a, b, r2); };
-            m[ab] = tab.generate_full(f);
-            return (*this)(a, b, r2);
+            if ( size_t(a.id) >= ntypes || size_t(b.id) >= ntypes )
+                return Tpairpot::operator()(a, b, r2);
+            const Table &t = tables[a.id * ntypes + b.id];
+            if ( t.n == 0 ) // pair not tabulated
+                return Tpairpot::operator()(a, b, r2);
+            if ( r2 >= t.rmax2 )
+                return 0;
+            if ( r2 < t.rmin2 )
+                return Tpairpot::operator()(a, b, r2);
+            double z = r2 - t.rmin2;
+            int i = std::min(int(z * t.invdz), t.n - 1);
+            return Ttabulator::polynomial(arena + t.offset + i * Ttabulator::stride, z - i * t.dz);
         }
     };
 
@@ -1538,7 +2063,7 @@ namespace Faunus
                 if ( r2 < it->second.rmax2 )
                     if ( r2 > it->second.rmin2 )
                         return tab.eval(it->second, r2);
-                return base::m[ab](a, b, r2); // fall back to original
+                return base::m[base::find(a, b)](a, b, r2); // fall back to original
             }
             return Tdefault::operator()(a, b, r2); // fall back to default
         }
@@ -1600,7 +2125,7 @@ namespace Faunus
                 for ( int j = 1; j < n; j++ )
                 {
                     double r2 = min + dr * ((double) j);
-                    ff1 << sqrt(r2) << " " << base::m[ab](a, b, r2) << endl;
+                    ff1 << sqrt(r2) << " " << base::m[base::find(a, b)](a, b, r2) << endl;
                     ff2 << sqrt(r2) << " " << tab.eval(it->second, r2) << endl;
                 }
             }
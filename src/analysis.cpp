@@ -37,16 +37,28 @@ namespace Faunus
     }
 
     void AnalysisBase::sample()
+    {
+        if ( due() )
+            run();
+    }
+
+    bool AnalysisBase::due()
     {
         stepcnt++;
         if ( stepcnt == steps )
         {
-            cnt++;
             stepcnt = 0;
-            timer.start();
-            _sample();
-            timer.stop();
+            return true;
         }
+        return false;
+    }
+
+    void AnalysisBase::run()
+    {
+        cnt++;
+        timer.start();
+        _sample();
+        timer.stop();
     }
 
     void AnalysisBase::_test( UnitTest &t ) {}
@@ -162,6 +174,7 @@ namespace Faunus
                     d.hist.setResolution(d.dr);
 		    d.hist2.setResolution(d.dr);
 		    d.Rhypersphere = i.value("Rhyper", -1.0);
+                    d.rmax = i.value("rmax", pc::infty);
                     datavec.push_back( d );
                 }
         }
@@ -177,18 +190,18 @@ namespace Faunus
     {
 	assert(V.cnt>0);
 	double Vr=1, sum = d.hist.sumy();
-	for (auto &i : d.hist.getMap()) {
+	d.hist.forEach( [&](double r, double &y) {
 	    if (d.dim==3)
-		Vr = 4 * pc::pi * pow(i.first,2) * d.dr;
+		Vr = 4 * pc::pi * pow(r,2) * d.dr;
 	    if (d.dim==2) {
-		Vr = 2 * pc::pi * i.first * d.dr;
+		Vr = 2 * pc::pi * r * d.dr;
 		if (d.Rhypersphere > 0)
-		    Vr = 2.0*pc::pi*d.Rhypersphere*sin(i.first/d.Rhypersphere) * d.dr;
+		    Vr = 2.0*pc::pi*d.Rhypersphere*sin(r/d.Rhypersphere) * d.dr;
 	    }
 	    if (d.dim==1)
 		Vr = d.dr;
-	    i.second = i.second/sum * V/Vr;
-	}
+	    y = y/sum * V/Vr;
+	} );
     }
 
     PairFunctionBase::~PairFunctionBase()
@@ -204,13 +217,99 @@ namespace Faunus
         cnt++;
         for ( auto i : v )
             i->sample();
+
+        if ( !w.empty() )
+        {
+            vector<char> due(w.size());
+            bool any = false;
+            for ( size_t i = 0; i < w.size(); i++ )
+                any = (due[i] = w[i]->due()) || any;
+            if ( any )
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                notFull.wait(lock, [&]() { return head - tail < capacity || error; });
+                if ( error )
+                    std::rethrow_exception(error);
+                size_t slot = head % capacity;
+                lock.unlock(); // slot is not read before `head` is advanced
+                capture(slot);
+                duemask[slot] = due;
+                lock.lock();
+                head++;
+                notEmpty.notify_one();
+            }
+        }
+    }
+
+    void CombinedAnalysis::backgroundLoop()
+    {
+        while ( true )
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            notEmpty.wait(lock, [&]() { return stop || tail < head; });
+            if ( tail == head )
+                return;
+            size_t slot = tail % capacity;
+            lock.unlock();
+
+            // exceptions must not escape the parallel region; keep the last one
+            std::exception_ptr e;
+            try
+            {
+                load(slot);
+            }
+            catch ( ... )
+            {
+                e = std::current_exception();
+            }
+            auto &due = duemask[slot];
+            int n = e ? 0 : w.size();
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+            for ( int i = 0; i < n; i++ )
+                if ( due[i] )
+                    try
+                    {
+                        w[i]->run();
+                    }
+                    catch ( ... )
+                    {
+#pragma omp critical
+                        e = std::current_exception();
+                    }
+
+            lock.lock();
+            if ( e )
+            {
+                error = e;
+                tail = head;
+                notFull.notify_all();
+                idle.notify_all();
+                return;
+            }
+            tail++;
+            notFull.notify_one();
+            idle.notify_all();
+        }
+    }
+
+    void CombinedAnalysis::flush()
+    {
+        if ( worker.joinable() )
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            idle.wait(lock, [&]() { return tail == head; });
+            if ( error )
+                std::rethrow_exception(error);
+        }
     }
 
     string CombinedAnalysis::info()
     {
+        flush();
         std::ostringstream o;
-        for ( auto i : v )
-            o << i->info();
+        for ( auto &l : {v, w} )
+            for ( auto i : l )
+                o << i->info();
         return o.str();
     }
 
@@ -220,20 +319,35 @@ namespace Faunus
 
     void CombinedAnalysis::test( UnitTest &test )
     {
-        for ( auto i : v )
-            i->test(test);
+        flush();
+        for ( auto &l : {v, w} )
+            for ( auto i : l )
+                i->test(test);
     }
 
     Tmjson CombinedAnalysis::json()
     {
+        flush();
         Tmjson js;
-        for ( auto i : v )
-            js = merge(js, i->json());
+        for ( auto &l : {v, w} )
+            for ( auto i : l )
+                js = merge(js, i->json());
         return js;
     }
 
     CombinedAnalysis::~CombinedAnalysis()
     {
+        if ( worker.joinable() )
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stop = true;
+            }
+            notEmpty.notify_one();
+            worker.join();
+        }
+        if ( error )
+            return;
         if (cnt>0) {
             std::ofstream f(jsonfile);
             if ( f )
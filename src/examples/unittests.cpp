@@ -37,28 +37,85 @@ TEST_CASE("Spline table", "Spline")
   checkTabulator(Tabulate::AndreaIntel<double>());
   checkTabulator(Tabulate::Andrea<double>());
   checkTabulator(Tabulate::Linear<double>());
+  checkTabulator(Tabulate::Uniform<double>());
 
-  PointParticle a,b;
-  a.charge=1;
-  b.charge=-1;
-  a.radius=b.radius=2;
   InputMap mcp("unittests.json");
   auto js = mcp.at("energy").at("nonbonded");
-  atom.include(mcp);
+  AtomMap atomold = atom; // restored below
+  atom.include(mcp["atomlist"]);
+  PointParticle a,b;
+  a = atom["sol1"]; // tables are generated from atom type properties
+  b = atom["sol1"];
+  a.radius=b.radius=2;
   Potential::Coulomb pot_org( js );
   Potential::PotentialTabulate<Potential::Coulomb> pot_tab( js );
+  pot_tab.tabulate( {a.id} ); // only pairs of used types are tabulated
+  CHECK( pot_tab.tabulated().size() == 1 );
 
   CHECK( pot_org.bjerrumLength() == Approx(560.455786334) );
 
-  double error = fabs( pot_org(a,b,25)-pot_tab(a,b,25) ) ;
-  CHECK(error>0);
-  CHECK(error<0.01);
+  for (double r2 : {1.5, 25.0, 9999.0}) {
+    double error = fabs( pot_org(a,b,r2)-pot_tab(a,b,r2) ) ;
+    CHECK(error>0);
+    CHECK(error<0.01);
+  }
+  CHECK( pot_tab(a,b,0.5) == Approx( pot_org(a,b,0.5) ) ); // below tab_rmin
+  CHECK( pot_tab(a,b,1e4) == 0 );                           // beyond tab_rmax
+  PointParticle c;
+  c = atom["sol2"];
+  c.charge = -1;
+  CHECK( pot_tab(a,c,25.0) == pot_org(a,c,25.0) );          // pair not tabulated
+  atom = atomold;
 
   // Check if negative potential operator works
   auto minus = Potential::Coulomb( js ) - Potential::Coulomb( js );
   CHECK( abs(minus(a,b,7)) < 1e-6 );
 }
 
+TEST_CASE("Table cache", "Store and map generated tables on disk")
+{
+  char dir[] = "/tmp/faunus-tabcache-XXXXXX";
+  REQUIRE( mkdtemp(dir) != nullptr );
+  setenv("FAUNUS_TABCACHE", dir, 1);
+
+  Tabulate::Andrea<double> t;
+  t.setRange(0.9, 100);
+  t.setTolerance(1e-6, 1e-2);
+  std::function<double(double)> f = [](double x) { return 1/x; };
+  auto d1 = Tabulate::TableCache::generate(t, "1/x", f);
+  Tabulate::TableCache::Tblocks blocks;
+  CHECK( Tabulate::TableCache::load("1/x", blocks) == nullptr ); // key includes tabulator and tolerances
+  auto d2 = Tabulate::TableCache::generate(t, "1/x", f);
+  CHECK( d1.r2 == d2.r2 );
+  CHECK( d1.c == d2.c );
+  CHECK( d2.rmax2 == Approx(d1.rmax2) );
+
+  InputMap mcp("unittests.json");
+  auto js = mcp.at("energy").at("nonbonded");
+  AtomMap atomold = atom; // restored below
+  atom.include(mcp["atomlist"]);
+  PointParticle a,b;
+  a = atom["sol1"];
+  b = atom["sol1"];
+  Potential::PotentialTabulate<Potential::Coulomb> pot1( js ), pot2( js );
+  pot1.tabulate( {a.id} ); // generated and stored
+  pot2.tabulate( {a.id} ); // mapped from disk
+  auto pot3 = pot2;
+  for (double r2 : {1.5, 25.0, 9999.0}) {
+    CHECK( pot2(a,b,r2) == pot1(a,b,r2) );
+    CHECK( pot3(a,b,r2) == pot1(a,b,r2) );
+  }
+  js["epsr"] = 1.0000001; // change beyond the printed precision of the potential
+  Potential::PotentialTabulate<Potential::Coulomb> pot4( js );
+  pot4.tabulate( {a.id} );
+  CHECK( pot4(a,b,25.0) != pot1(a,b,25.0) );
+  CHECK( pot4(a,b,25.0) == Approx( Potential::Coulomb(js)(a,b,25.0) ).epsilon(0.01) );
+  atom = atomold;
+
+  unsetenv("FAUNUS_TABCACHE");
+  std::system( (string("rm -rf ") + dir).c_str() );
+}
+
 /*
  * Check various copying operations
  * between particle types
@@ -192,6 +249,1177 @@ TEST_CASE("Ewald Test","Ion-Ion- and Dipole-Dipole-interaction")
   CHECK(Energy::systemEnergy(spc,pot,spc.p) == Approx(-2.0003749*lB));  // Total dipole-dipole interaction energy
 }
 
+TEST_CASE("Ewald update", "Compare incremental and full reciprocal space update")
+{
+  typedef Space<Geometry::Cuboid,DipoleParticle> Tspace;
+  InputMap in("unittests.json");
+  Tspace spc(in);
+  auto pot = Energy::NonbondedEwald<Tspace,Potential::HardSphere>(in);
+  auto potref = Energy::NonbondedEwald<Tspace,Potential::HardSphere>(in);
+  spc.p.resize(20);
+  for (auto &a : spc.p) {
+    spc.geo.randompos(a);
+    a.charge = (&a - &spc.p[0]) % 2 ? 1.0 : -1.0;
+  }
+  spc.trial = spc.p;
+  Group g(0,19);
+  spc.groupList().push_back(&g);
+  pot.setSpace(spc);
+  CHECK( pot.external(spc.trial) == Approx( pot.external(spc.p) ) );
+
+  // move three particles and compare with a fresh, full calculation
+  Tspace::Change c;
+  for (int i : {2, 7, 19}) {
+    spc.trial[i].translate(spc.geo, Point(1.2, -0.4, 3.3));
+    c.mvGroup[0].push_back(i);
+  }
+  pot.updateChange(c);
+  double utrial = pot.external(spc.trial);
+  spc.p = spc.trial;
+  potref.setSpace(spc);
+  CHECK( utrial == Approx( potref.external(spc.p) ) );
+
+  pot.update(true);
+  CHECK( pot.external(spc.p) == Approx( potref.external(spc.p) ) );
+
+  // rejected group move leaves energy unchanged
+  c.clear();
+  c.mvGroup[0];
+  for (auto i : g)
+    spc.trial[i].translate(spc.geo, Point(0.5, 0.5, 0.5));
+  pot.updateChange(c);
+  pot.external(spc.trial);
+  spc.trial = spc.p;
+  pot.update(false);
+  CHECK( pot.external(spc.p) == Approx( potref.external(spc.p) ) );
+
+  // volume moves as in Isobaric: positions are scaled with the box, but one
+  // particle is also displaced so that its phase must be re-evaluated
+  Point oldlen = spc.geo.len;
+  for (double f : {1.1, 0.95}) {
+    c.clear();
+    c.mvGroup[0];
+    c.geometryChange = true;
+    c.dV = spc.geo.getVolume()*(f*f*f - 1);
+    for (auto i : g)
+      spc.trial[i] = spc.p[i] * f;
+    spc.trial[5].translate(spc.geo, Point(0.3, 0.0, -0.2));
+    pot.updateChange(c);
+    double uold = pot.external(spc.p);
+    spc.geo.setlen(oldlen * f);
+    pot.setSpace(spc);
+    utrial = pot.external(spc.trial);
+    if (f > 1) { // reject
+      spc.geo.setlen(oldlen);
+      pot.setSpace(spc);
+      spc.trial = spc.p;
+      pot.update(false);
+      CHECK( pot.external(spc.p) == Approx( uold ) );
+    } else {     // accept
+      pot.setSpace(spc);
+      spc.p = spc.trial;
+      pot.update(true);
+      potref.setSpace(spc);
+      CHECK( utrial == Approx( potref.external(spc.p) ) );
+      CHECK( pot.external(spc.p) == Approx( potref.external(spc.p) ) );
+    }
+  }
+
+  // external energy change from moved particles only
+  for (bool accept : {true, false, true}) {
+    c.clear();
+    for (int i : {4, 11}) {
+      spc.trial[i].translate(spc.geo, Point(-0.7, 2.1, 0.4));
+      c.mvGroup[0].push_back(i);
+    }
+    spc.trial[4].mu() = Point(0,1,0);
+    spc.trial[4].muscalar() = 0.5;
+    auto pold = spc.p;
+    spc.p = spc.trial;
+    potref.setSpace(spc);
+    double du = potref.external(spc.p);
+    spc.p = pold;
+    potref.setSpace(spc);
+    du -= potref.external(spc.p);
+    pot.updateChange(c);
+    CHECK( pot.externalChange(c) == Approx( du ) );
+    if (accept)
+      spc.p = spc.trial;
+    else
+      spc.trial = spc.p;
+    pot.update(accept);
+    potref.setSpace(spc);
+    CHECK( pot.external(spc.p) == Approx( potref.external(spc.p) ) );
+  }
+
+  // accepted move whose trial energy was never evaluated
+  c.clear();
+  spc.trial[8].translate(spc.geo, Point(1.5, 0.2, -0.9));
+  c.mvGroup[0].push_back(8);
+  pot.updateChange(c);
+  spc.p = spc.trial;
+  pot.update(true);
+  c.clear();
+  spc.trial[3].translate(spc.geo, Point(-0.6, 1.1, 0.8));
+  c.mvGroup[0].push_back(3);
+  potref.setSpace(spc);
+  double du = -potref.external(spc.p);
+  std::swap(spc.p, spc.trial);
+  potref.setSpace(spc);
+  du += potref.external(spc.p);
+  std::swap(spc.p, spc.trial);
+  pot.updateChange(c);
+  CHECK( pot.externalChange(c) == Approx( du ) );
+  spc.trial = spc.p;
+  pot.update(false);
+}
+
+TEST_CASE("PME", "Compare particle mesh and direct Ewald reciprocal energies")
+{
+  typedef Space<Geometry::Cuboid,PointParticle> Tspace;
+  InputMap in("unittests.json");
+  in["energy"]["nonbonded"]["ewald"]["eps_surf"] = 0.0; // tinfoil
+  in["energy"]["nonbonded"]["ewald"]["spline_order"] = 6;
+  Tspace spc(in);
+  auto pme = Energy::NonbondedPME<Tspace,Potential::HardSphere>(in);
+  auto pmeref = Energy::NonbondedPME<Tspace,Potential::HardSphere>(in);
+  auto ewald = Energy::NonbondedEwald<Tspace,Potential::HardSphere,true,false,false>(in);
+  spc.p.resize(20);
+  for (auto &a : spc.p) {
+    spc.geo.randompos(a);
+    a.charge = (&a - &spc.p[0]) % 2 ? 1.0 : -1.0;
+  }
+  spc.trial = spc.p;
+  Group g(0,19);
+  spc.groupList().push_back(&g);
+  pme.setSpace(spc);
+  ewald.setSpace(spc);
+  CHECK( pme.external(spc.p) == Approx( ewald.external(spc.p) ).epsilon(1e-4) );
+  CHECK( pme.g_external(spc.p,g) == Approx( ewald.g_external(spc.p,g) ) );
+
+  // sparse update of a single particle move, then acceptance
+  Tspace::Change c;
+  c.mvGroup[0].push_back(3);
+  spc.trial[3].translate(spc.geo, Point(1.2, -0.4, 3.3));
+  pme.updateChange(c);
+  double utrial = pme.external(spc.trial);
+  spc.p = spc.trial;
+  pmeref.setSpace(spc);
+  CHECK( utrial == Approx( pmeref.external(spc.p) ) );
+  pme.update(true);
+  CHECK( pme.external(spc.p) == Approx( pmeref.external(spc.p) ) );
+
+  // rejected group move leaves energy unchanged
+  c.clear();
+  c.mvGroup[0];
+  for (auto i : g)
+    spc.trial[i].translate(spc.geo, Point(0.5, 0.1*i, 0.5));
+  pme.updateChange(c);
+  CHECK( pme.external(spc.trial) != Approx( pme.external(spc.p) ) );
+  spc.trial = spc.p;
+  pme.update(false);
+  CHECK( pme.external(spc.p) == Approx( pmeref.external(spc.p) ) );
+
+  // accepted empty change (e.g. charge swap) without evaluating the trial energy
+  c.clear();
+  std::swap(spc.trial[0].charge, spc.trial[5].charge);
+  spc.trial[0].translate(spc.geo, Point(-2.0, 0.7, 1.1));
+  pme.updateChange(c);
+  spc.p = spc.trial;
+  pme.update(true);
+  pmeref.setSpace(spc);
+  CHECK( pme.external(spc.p) == Approx( pmeref.external(spc.p) ) );
+}
+
+TEST_CASE("Cell list", "Compare cell list and N-squared nonbonded energies")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  typedef Potential::CutShift<Potential::Coulomb, false> Tpairpot;
+  InputMap in("unittests.json");
+  in["energy"]["nonbonded"]["cutoff"] = 3.0;
+  Tspace spc(in);
+  Energy::Nonbonded<Tspace,Tpairpot> pot(in);
+  Energy::NonbondedCellList<Tspace,Tpairpot> potcell(in);
+
+  spc.p.resize(200);
+  for (auto &a : spc.p) {
+    spc.geo.randompos(a);
+    a.charge = slump.half();
+  }
+  spc.trial = spc.p;
+  Group g(0,199);
+  spc.groupList().push_back(&g);
+  pot.setSpace(spc);
+  potcell.setSpace(spc);
+
+  CHECK( potcell.g_internal(spc.p,g) == Approx( pot.g_internal(spc.p,g) ) );
+  for (int i : {0, 50, 199})
+    CHECK( potcell.i2all(spc.p,i) == Approx( pot.i2all(spc.p,i) ) );
+
+  // single particle trial move followed by acceptance
+  Tspace::Change c;
+  c.clear();
+  c.mvGroup[0].push_back(10);
+  spc.trial[10].translate(spc.geo, Point(2.5,-1.0,0.7));
+  potcell.updateChange(c);
+  CHECK( potcell.i2all(spc.trial,10) == Approx( pot.i2all(spc.trial,10) ) );
+  CHECK( potcell.i2all(spc.trial,11) == Approx( pot.i2all(spc.trial,11) ) );
+  CHECK( potcell.g_internal(spc.trial,g) == Approx( pot.g_internal(spc.trial,g) ) );
+  spc.p[10] = spc.trial[10];
+  potcell.update(true);
+  CHECK( potcell.i2all(spc.p,10) == Approx( pot.i2all(spc.p,10) ) );
+  CHECK( potcell.g_internal(spc.p,g) == Approx( pot.g_internal(spc.p,g) ) );
+
+  // lazy rebuild is done by prepare(), ahead of concurrent evaluation
+  potcell.rebuild();
+  auto n = potcell.numRebuilds();
+  potcell.prepare();
+  CHECK( potcell.numRebuilds() == n + 1 );
+  CHECK( potcell.g_internal(spc.p,g) == Approx( pot.g_internal(spc.p,g) ) );
+  CHECK( potcell.numRebuilds() == n + 1 );
+}
+
+TEST_CASE("Verlet list", "Compare Verlet list and N-squared nonbonded energies")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  typedef Potential::CutShift<Potential::Coulomb, false> Tpairpot;
+  InputMap in("unittests.json");
+  in["energy"]["nonbonded"]["cutoff"] = 3.0;
+  in["energy"]["nonbonded"]["skin"] = 1.0;
+  Tspace spc(in);
+  Energy::Nonbonded<Tspace,Tpairpot> pot(in);
+  Energy::NonbondedVerlet<Tspace,Tpairpot> potverlet(in);
+
+  spc.p.resize(200);
+  for (auto &a : spc.p) {
+    spc.geo.randompos(a);
+    a.charge = slump.half();
+  }
+  spc.trial = spc.p;
+  Group g(0,199);
+  spc.groupList().push_back(&g);
+  pot.setSpace(spc);
+  potverlet.setSpace(spc);
+
+  CHECK( potverlet.g_internal(spc.p,g) == Approx( pot.g_internal(spc.p,g) ) );
+  CHECK( potverlet.numRebuilds() == 1 );
+
+  // accepted single particle moves; the list must be rebuilt as displacements accumulate
+  Tspace::Change c;
+  for (int n=0; n<10; n++) {
+    int i = n % 3;
+    c.clear();
+    c.mvGroup[0].push_back(i);
+    spc.trial[i].translate(spc.geo, Point(0.4,-0.2,0.1));
+    potverlet.updateChange(c);
+    CHECK( potverlet.i2all(spc.trial,i) == Approx( pot.i2all(spc.trial,i) ) );
+    CHECK( potverlet.g_internal(spc.trial,g) == Approx( pot.g_internal(spc.trial,g) ) );
+    spc.p[i] = spc.trial[i];
+    potverlet.update(true);
+    CHECK( potverlet.i2all(spc.p,i) == Approx( pot.i2all(spc.p,i) ) );
+  }
+  CHECK( potverlet.numRebuilds() > 1 );
+  CHECK( potverlet.numRebuilds() < 10 );
+
+  // lazy rebuild is done by prepare(), ahead of concurrent evaluation
+  potverlet.rebuild();
+  auto n = potverlet.numRebuilds();
+  potverlet.prepare();
+  CHECK( potverlet.numRebuilds() == n + 1 );
+  CHECK( potverlet.g_internal(spc.p,g) == Approx( pot.g_internal(spc.p,g) ) );
+  CHECK( potverlet.numRebuilds() == n + 1 );
+}
+
+/* check structure-of-arrays nonbonded energy against N-squared loop */
+template<class Tgeometry, class Tpairpot=Potential::CoulombLJ>
+void checkArrays() {
+  typedef Space<Tgeometry, PointParticle> Tspace;
+  InputMap in("unittests.json");
+  in["energy"]["nonbonded"]["eps"] = 0.05;
+  in["energy"]["nonbonded"]["cutoff"] = 4.0;
+  in["energy"]["nonbonded"]["debyelength"] = 7.0;
+  in["energy"]["nonbonded"]["coulombtype"] = "qpotential";
+  Tspace spc(in);
+  Energy::Nonbonded<Tspace,Tpairpot> pot(in);
+  Energy::NonbondedArrays<Tspace,Tpairpot> potsoa(in);
+
+  spc.p.resize(100);
+  for (auto &a : spc.p) {
+    spc.geo.randompos(a);
+    a.charge = slump.half();
+    a.radius = 0.2 + 0.3 * slump();
+  }
+  spc.trial = spc.p;
+  Group g1(0,49), g2(50,99);
+  spc.groupList().push_back(&g1);
+  spc.groupList().push_back(&g2);
+  pot.setSpace(spc);
+  potsoa.setSpace(spc);
+
+  CHECK( spc.soa.size() == spc.p.size() );
+  CHECK( potsoa.g_internal(spc.p,g1) == Approx( pot.g_internal(spc.p,g1) ) );
+  CHECK( potsoa.g2g(spc.p,g1,g2) == Approx( pot.g2g(spc.p,g1,g2) ) );
+  CHECK( potsoa.i2g(spc.p,g1,10) == Approx( pot.i2g(spc.p,g1,10) ) );
+  PointParticle ghost = spc.p[0];
+  ghost.translate(spc.geo, Point(0.3,0.2,0.1));
+  CHECK( potsoa.all2p(spc.p,ghost) == Approx( pot.all2p(spc.p,ghost) ) );
+
+  // trial move; arrays are synced as done by Move::Movebase
+  typename Tspace::Change c;
+  c.mvGroup[1].push_back(60);
+  spc.trial[60].translate(spc.geo, Point(1.5,-1.0,0.5));
+  spc.syncArrays(c);
+  CHECK( potsoa.i2all(spc.trial,60) == Approx( pot.i2all(spc.trial,60) ) );
+  CHECK( potsoa.i2all(spc.p,60) == Approx( pot.i2all(spc.p,60) ) );
+  spc.trial = spc.p;
+
+  // insertion through Space keeps arrays in sync
+  spc.insert(ghost, 10);
+  CHECK( spc.soa.size() == spc.p.size() );
+  CHECK( potsoa.g2g(spc.p,g1,g2) == Approx( pot.g2g(spc.p,g1,g2) ) );
+}
+
+TEST_CASE("Particle arrays", "Compare structure-of-arrays and N-squared nonbonded energies")
+{
+  using namespace Potential;
+  CHECK( hasBlock<CoulombLJ>::value );
+  CHECK( !hasBlock<CoulombHS>::value );
+  checkArrays<Geometry::Cuboid>();
+  checkArrays<Geometry::Cuboidslit>();
+  checkArrays<Geometry::Cuboid, CoulombWolfLJ>();
+  checkArrays<Geometry::Cuboid, DebyeHuckelLJ>();
+  checkArrays<Geometry::Cuboid, CombinedPairPotential<CoulombGalore, LennardJonesLB>>();
+  checkArrays<Geometry::Cuboid, CoulombWCA>(); // scalar fallback
+}
+
+TEST_CASE("Potential map", "Compare type-pair dispatch of PotentialMap and PotentialMatrix")
+{
+  using namespace Potential;
+  InputMap in("unittests.json");
+  Space<Geometry::Cuboid, PointParticle> spc(in);
+  Tmjson &j = in["energy"]["nonbonded"];
+  PotentialMap<Coulomb> map(j);
+  PotentialMatrix<Coulomb, Harmonic, FENE> matrix(j);
+  Coulomb coulomb(j);
+  Harmonic harmonic(1.5, 2.0);
+  FENE fene(0.8, 8.0);
+  int na = atom["Na"].id, cl = atom["Cl"].id, mm = atom["MM"].id;
+  map.add(na, cl, harmonic);
+  map.add(mm, mm, fene);
+  matrix.add(na, cl, harmonic);
+  matrix.add(mm, mm, fene);
+
+  PointParticle a, b;
+  a.charge = 1.0;
+  b.charge = -1.0;
+  double r2 = 16.0;
+  Point r(4,0,0);
+  for (auto ids : vector<std::pair<int,int>>{ {na,cl}, {cl,na}, {mm,mm}, {na,na}, {na,mm} }) {
+    a.id = ids.first;
+    b.id = ids.second;
+    double u = coulomb(a,b,r2);
+    Point f = coulomb.force(a,b,r2,r);
+    if (a.id != b.id && (a.id == na || a.id == cl) && (b.id == na || b.id == cl)) {
+      u = harmonic(a,b,r2);
+      f = harmonic.force(a,b,r2,r);
+    } else if (a.id == mm && b.id == mm) {
+      u = fene(a,b,r2);
+      f = fene.force(a,b,r2,r);
+    }
+    CHECK( map(a,b,r2) == Approx(u) );
+    CHECK( matrix(a,b,r2) == Approx(u) );
+    CHECK( (matrix.force(a,b,r2,r) - f).norm() == Approx(0) );
+    CHECK( (map.force(a,b,r2,r) - f).norm() == Approx(0) );
+  }
+
+  // type added after construction uses the default potential
+  a.id = atom.size() + 10;
+  b.id = na;
+  CHECK( matrix(a,b,r2) == Approx(coulomb(a,b,r2)) );
+  CHECK( (matrix.force(a,b,r2,r) - coulomb.force(a,b,r2,r)).norm() == Approx(0) );
+}
+
+TEST_CASE("Trial index", "Sparse accept and reject of trial particles")
+{
+  InputMap in("unittests.json");
+  Space<Geometry::Cuboid, PointParticle> spc(in);
+  spc.p.resize(50);
+  for (auto &a : spc.p)
+    spc.geo.randompos(a);
+  spc.trial = spc.p;
+
+  // accept: only touched particles are copied
+  spc.trial[3].translate(spc.geo, Point(0.5,0,0));
+  spc.trial[7].charge = 2.0;
+  spc.trial[9].charge = 3.0; // deliberately not touched
+  spc.touch(3);
+  spc.touch(7);
+  spc.touch(3);
+  CHECK( spc.touchedTrial().indices().size() == 2 );
+  CHECK( spc.touchedTrial().contains(7) );
+  CHECK( !spc.touchedTrial().contains(9) );
+  spc.acceptTrial();
+  CHECK( spc.touchedTrial().empty() );
+  CHECK( spc.p[3] == spc.trial[3] );
+  CHECK( spc.p[7].charge == Approx(2.0) );
+  CHECK( spc.p[9].charge != Approx(3.0) );
+  spc.trial[9] = spc.p[9];
+  CHECK( spc.p == spc.trial );
+
+  // reject: touched particles are restored
+  spc.trial[11].translate(spc.geo, Point(0,1,0));
+  spc.touch(11);
+  spc.rejectTrial();
+  CHECK( spc.p == spc.trial );
+
+  // all particles
+  for (auto &a : spc.trial)
+    a.charge = -1.0;
+  spc.touchAll();
+  CHECK( spc.touchedTrial().contains(49) );
+  spc.acceptTrial();
+  CHECK( spc.p == spc.trial );
+  CHECK( spc.touchedTrial().empty() );
+}
+
+TEST_CASE("Group lookup", "Compare particle-to-group index with linear search")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  InputMap in("unittests.json");
+  Tspace spc(in);
+  auto &square = spc.molecule[ spc.molecule["square"].id ];
+  auto &salt = spc.molecule[ spc.molecule["salt"].id ];
+  for (int n=0; n<5; n++)
+    spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  for (int n=0; n<3; n++)
+    spc.insert(salt.id, salt.getRandomConformation(spc.geo, spc.p)); // same atomic group
+
+  auto check = [&]() {
+    for (int i=0; i<(int)spc.p.size(); i++) {
+      Group *linear = nullptr;
+      for (auto g : spc.groupList())
+        if (g->find(i)) {
+          linear = g;
+          break;
+        }
+      CHECK( spc.findGroup(i) == linear );
+    }
+    for (size_t k=0; k<spc.groupList().size(); k++)
+      CHECK( spc.findIndex(spc.groupList()[k]) == (int)k );
+    CHECK( spc.findGroup(spc.p.size()) == nullptr );
+  };
+
+  check();
+  spc.eraseGroup(1);
+  check();
+  spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  check();
+  spc.erase(spc.groupList().back()->back());
+  check();
+
+  // groups modified directly, bypassing Space
+  Group g(spc.p.size(), spc.p.size()+1);
+  spc.p.resize(spc.p.size()+2);
+  spc.trial = spc.p;
+  spc.groupList().push_back(&g);
+  check();
+  spc.groupList().pop_back();
+}
+
+TEST_CASE("Manybody", "Compare indexed manybody terms with direct summation")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  typedef Tspace::ParticleVector Tpvec;
+  InputMap in("unittests.json");
+  Tspace spc(in);
+  auto &square = spc.molecule[ spc.molecule["square"].id ];
+  for (int n=0; n<3; n++)
+    spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  for (auto &a : spc.p)
+    spc.geo.randompos(a);
+  spc.trial = spc.p;
+
+  Energy::Manybody<Tspace> pot(spc);
+  pot.addAngle(0, 1, 2, 0.5, 90.);
+  pot.addAngle(1, 2, 3, 0.8, 100.);
+  pot.addAngle(4, 5, 6, 0.3, 60.);
+  pot.addDihedral(0, 1, 2, 3, 1.0, 0., 2);
+  pot.addDihedral(2, 3, 4, 5, 0.7, 30., 3); // spans two molecules
+  pot.addAngle(3, 4, 8, 0.2, 120.);         // spans three molecules
+
+  auto angle = [&](const Tpvec &p, int i, int j, int k, double kf, double deg) {
+    Point a = spc.geo.vdist(p[i], p[j]), b = spc.geo.vdist(p[k], p[j]);
+    double da = std::acos( a.dot(b) / (a.norm()*b.norm()) ) - deg*pc::pi/180;
+    return 0.5*kf*da*da;
+  };
+  auto dihedral = [&](const Tpvec &p, int i, int j, int k, int l, double kf, double deg, int n) {
+    Point b1 = spc.geo.vdist(p[j], p[i]), b2 = spc.geo.vdist(p[k], p[j]), b3 = spc.geo.vdist(p[l], p[k]);
+    Point n1 = b1.cross(b2), n2 = b2.cross(b3);
+    double phi = std::acos( n1.dot(n2) / (n1.norm()*n2.norm()) );
+    if (b1.dot(n2) < 0)
+      phi = -phi;
+    return kf*(1 + std::cos(n*phi - deg*pc::pi/180));
+  };
+  auto total = [&](const Tpvec &p) {
+    return angle(p, 0, 1, 2, 0.5, 90.) + angle(p, 1, 2, 3, 0.8, 100.) + angle(p, 4, 5, 6, 0.3, 60.)
+      + dihedral(p, 0, 1, 2, 3, 1.0, 0., 2) + dihedral(p, 2, 3, 4, 5, 0.7, 30., 3)
+      + angle(p, 3, 4, 8, 0.2, 120.);
+  };
+  auto system = [&](const Tpvec &p) {
+    double u = pot.external(p);
+    for (auto g : spc.groupList())
+      u += pot.g_internal(p, *g);
+    return u;
+  };
+  CHECK( system(spc.p) == Approx( total(spc.p) ) );
+
+  // single atom moves: intra-group terms via i_internal, the rest via externalChange
+  for (int i : {1, 3, 4, 8, 10}) {
+    Tspace::Change c;
+    c.mvGroup[spc.findIndex(spc.findGroup(i))].push_back(i);
+    spc.trial[i].translate(spc.geo, Point(0.3, -0.5, 0.2));
+    double du = pot.i_internal(spc.trial, i) - pot.i_internal(spc.p, i) + pot.externalChange(c);
+    CHECK( du == Approx( total(spc.trial) - total(spc.p) ) );
+    spc.p[i] = spc.trial[i];
+  }
+
+  // rigid molecule translation leaves only inter-group terms
+  Tspace::Change c;
+  c.mvGroup[1];
+  for (auto i : *spc.groupList()[1])
+    spc.trial[i].translate(spc.geo, Point(1.0, 0.5, -2.0));
+  CHECK( pot.g_internal(spc.trial, *spc.groupList()[1]) == Approx( pot.g_internal(spc.p, *spc.groupList()[1]) ) );
+  CHECK( pot.externalChange(c) == Approx( total(spc.trial) - total(spc.p) ) );
+  spc.p = spc.trial;
+  CHECK( system(spc.p) == Approx( total(spc.p) ) );
+}
+
+TEST_CASE("Bonded", "Compare CSR bond table with direct summation")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  typedef Tspace::ParticleVector Tpvec;
+  InputMap in("unittests.json");
+  Tspace spc(in);
+  auto &square = spc.molecule[ spc.molecule["square"].id ];
+  square.bonds.clear();
+  for (int i=0; i<3; i++)
+    square.bonds.push_back( Faunus::Bonded::BondData(i, i+1, 0.5, 2.0) );
+  for (int n=0; n<4; n++)
+    spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  spc.trial = spc.p;
+
+  Energy::Bonded<Tspace> pot;
+  pot.setSpace(spc); // molecular bonds of current and future groups
+  pot.CrossGroupBonds = true;
+  pot.add(0, 2, Potential::FENE(0.8, 30.));
+  pot.add(1, 3, Potential::Harmonic(0.2, 1.0) + Potential::Harmonic(0.1, 3.0)); // generic
+  pot.add(3, 4, Potential::Harmonic(0.3, 4.0));  // crosses groups
+  pot.add(0, 1, Potential::Harmonic(0.9, 1.5));  // replaces molecular bond
+
+  typedef std::function<double(double)> Tfunc;
+  auto harmonic = [](double k, double req) { return Tfunc([=](double r) { return k*(r-req)*(r-req); }); };
+  auto reference = [&]() {
+    std::vector<std::tuple<int,int,Tfunc>> v;
+    for (auto g : spc.groupList())
+      for (int i=0; i<3; i++)
+        if (g != spc.groupList()[0] || i != 0)
+          v.push_back( std::make_tuple(g->front()+i, g->front()+i+1, harmonic(0.5, 2.0)) );
+    v.push_back( std::make_tuple(0, 2, Tfunc([](double r) { return -0.5*0.8*900*std::log(1-r*r/900); })) );
+    v.push_back( std::make_tuple(1, 3, Tfunc([=](double r) { return harmonic(0.2,1.0)(r) + harmonic(0.1,3.0)(r); })) );
+    v.push_back( std::make_tuple(3, 4, harmonic(0.3, 4.0)) );
+    v.push_back( std::make_tuple(0, 1, harmonic(0.9, 1.5)) );
+    return v;
+  };
+  auto check = [&](Tpvec &p) {
+    auto v = reference();
+    auto u = [&](const std::tuple<int,int,Tfunc> &b) {
+      return std::get<2>(b)( spc.geo.dist(p[std::get<0>(b)], p[std::get<1>(b)]) );
+    };
+    double sum = 0;
+    for (auto &b : v)
+      sum += u(b);
+    CHECK( pot.total(p) == Approx(sum) );
+    CHECK( pot.getBondList().size() == v.size() );
+    for (int i=0; i<(int)p.size(); i++) {
+      double ui = 0;
+      for (auto &b : v)
+        if (std::get<0>(b) == i || std::get<1>(b) == i)
+          ui += u(b);
+      CHECK( pot.i2all(p, i) == Approx(ui) );
+    }
+    for (auto g : spc.groupList()) {
+      double ug = 0;
+      for (auto &b : v)
+        if (g->find(std::get<0>(b)) && g->find(std::get<1>(b)))
+          ug += u(b);
+      CHECK( pot.g_internal(p, *g) == Approx(ug) );
+    }
+    Group &g0 = *spc.groupList()[0], &g1 = *spc.groupList()[1];
+    CHECK( pot.g2g(p, g0, g1) == Approx( u(v[v.size()-2]) ) );
+    CHECK( pot.i2i(p, 2, 0) == Approx( u(v[v.size()-4]) ) );
+    CHECK( pot.i2i(p, 0, 5) == 0 );
+  };
+
+  check(spc.p);
+  spc.trial[2].translate(spc.geo, Point(0.4, -0.3, 0.2));
+  spc.trial[9].translate(spc.geo, Point(-0.2, 0.5, 0.1));
+  check(spc.trial);
+  spc.trial = spc.p;
+
+  spc.eraseGroup(2);          // later group shifts down
+  check(spc.p);
+  spc.eraseGroup(2);          // insertion may reuse the group address
+  spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  spc.trial = spc.p;
+  check(spc.p);
+
+  // repeated deletion and insertion, as in grand canonical moves
+  string info = pot.info();
+  for (int n=0; n<10; n++) {
+    spc.eraseGroup(spc.groupList().size()-1);
+    spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  }
+  spc.trial = spc.p;
+  check(spc.p);
+  CHECK( pot.info() == info );
+}
+
+TEST_CASE("Group pair cache", "Compare cached and direct group-group energies")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  typedef Potential::CutShift<Potential::Coulomb, false> Tpairpot;
+  InputMap in("unittests.json");
+  in["energy"]["nonbonded"]["cutoff"] = 4.0;
+  Tspace spc(in);
+  auto &square = spc.molecule[ spc.molecule["square"].id ];
+  for (int n=0; n<6; n++)
+    spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  Tspace::ParticleVector salt(30);
+  for (auto &a : salt) {
+    a = atom["Na"];
+    spc.geo.randompos(a);
+  }
+  spc.insert(spc.molecule["salt"].id, salt);
+  for (auto &a : spc.p)
+    a.charge = slump.half();
+  spc.trial = spc.p;
+
+  in["moves"]["isobaric"] = { {"dp", 0.05}, {"pressure", 10.0} };
+  auto &pot = Energy::Nonbonded<Tspace,Tpairpot>(in) + Energy::ExternalPressure<Tspace>(in);
+  Energy::GroupPairCache<Tspace> cache(pot, spc);
+  Tmjson jt = { {"square", { {"dp", 2.0}, {"dprot", 1.0} } } };
+  Move::TranslateRotate<Tspace> mv(pot, spc, jt);
+  Move::Isobaric<Tspace> iso(pot, spc, in["moves"]["isobaric"]);
+  Tmjson ja = { {"salt", Tmjson::object()} };
+  Move::AtomicTranslation<Tspace> at(pot, spc, ja); // rows recomputed lazily
+  mv.setPairCache(cache);
+  iso.setPairCache(cache);
+  at.setPairCache(cache);
+
+  double u0 = Energy::systemEnergy(spc, pot, spc.p);
+  CHECK( Energy::cachedSystemEnergy(spc, pot, cache) == Approx(u0) );
+
+  double du = 0;
+  for (int n=0; n<100; n++) {
+    du += mv.move();
+    if (n % 10 == 0)
+      du += iso.move();
+    if (n % 3 == 0)
+      for (int k=0; k<5; k++)
+        du += at.move();
+  }
+  CHECK( mv.getAcceptance() > 0 );
+  CHECK( at.getAcceptance() > 0 );
+  double u1 = Energy::systemEnergy(spc, pot, spc.p);
+  CHECK( u1 == Approx(u0 + du) );
+  CHECK( Energy::cachedSystemEnergy(spc, pot, cache) == Approx(u1) );
+
+  auto &g = spc.groupList();
+  for (size_t i=0; i<g.size(); i++)
+    for (size_t j=0; j<g.size(); j++)
+      if (i != j)
+        CHECK( cache(i,j) == Approx( pot.g2g(spc.p, *g[i], *g[j]) ) );
+
+  // insertion invalidates the cache
+  spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  spc.trial = spc.p;
+  CHECK( cache.matrix().rows() == (int)g.size() );
+  CHECK( cache(0, g.size()-1) == Approx( pot.g2g(spc.p, *g.front(), *g.back()) ) );
+}
+
+TEST_CASE("Parallel group energy", "Compare parallel and serial moved-vs-static group energies")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  typedef Potential::CutShift<Potential::Coulomb, false> Tpairpot;
+  InputMap in("unittests.json");
+  in["energy"]["nonbonded"]["cutoff"] = 4.0;
+  Tspace spc(in);
+  auto &square = spc.molecule[ spc.molecule["square"].id ];
+  for (int n=0; n<8; n++)
+    spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  for (auto &a : spc.p)
+    a.charge = slump.half();
+  spc.trial = spc.p;
+  Energy::Nonbonded<Tspace,Tpairpot> pot(in);
+  pot.setSpace(spc);
+
+  auto &g = spc.groupList();
+  g[1]->translate(spc, Point(1.0, -0.5, 0.3));
+  g[5]->translate(spc, Point(-2.0, 0.5, 1.1));
+  double du = 0;
+  for (int j=0; j<(int)g.size(); j++)
+    if (j != 1 && j != 5)
+      for (int i : {1, 5})
+        du += pot.g2g(spc.trial, *g[i], *g[j]) - pot.g2g(spc.p, *g[i], *g[j]);
+  Energy::ParallelGroupEnergy<Tspace> par;
+  CHECK( par.change(pot, spc, {g[1], g[5]}) == Approx(du) );
+  g[1]->undo(spc);
+  g[5]->undo(spc);
+
+  Tmjson jt = { {"square", { {"dp", 2.0}, {"dprot", 1.0} } } };
+  Move::TranslateRotate<Tspace> mv(pot, spc, jt);
+  mv.parallelGroups = true;
+  double u0 = Energy::systemEnergy(spc, pot, spc.p);
+  du = 0;
+  for (int n=0; n<50; n++)
+    du += mv.move();
+  CHECK( mv.getAcceptance() > 0 );
+  CHECK( Energy::systemEnergy(spc, pot, spc.p) == Approx(u0 + du) );
+}
+
+TEST_CASE("Batched Widom", "Compare batched ghost insertion with one-by-one insertion")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  typedef Potential::CutShift<Potential::Coulomb, false> Tpairpot;
+  InputMap in("unittests.json");
+  in["energy"]["nonbonded"]["cutoff"] = 3.0;
+  Tspace spc(in);
+  Energy::Nonbonded<Tspace,Tpairpot> pot(in);
+  Energy::NonbondedCellList<Tspace,Tpairpot> potcell(in);
+
+  spc.p.resize(200);
+  for (auto &a : spc.p) {
+    spc.geo.randompos(a);
+    a.charge = slump.half();
+  }
+  spc.trial = spc.p;
+  Group g(0,199);
+  spc.groupList().push_back(&g);
+  pot.setSpace(spc);
+  potcell.setSpace(spc);
+
+  Tmjson jw = { {"nstep", 1}, {"ninsert", 50}, {"parallel", true}, {"particles", Tmjson::array()} };
+  Analysis::Widom<Tspace> widom(jw, potcell, spc);
+  std::vector<PointParticle> ghosts(2);
+  ghosts[0].charge = 0.01;
+  ghosts[1].charge = -0.01;
+  for (auto &a : ghosts)
+    widom.add(a);
+
+  auto eng = slump.eng;
+  for (int n=0; n<4; n++)
+    widom.sample();
+  slump.eng = eng;
+
+  Average<double> expsum;
+  for (int n=0; n<4*50; n++) {
+    for (auto &a : ghosts)
+      spc.geo.randompos(a);
+    double du = pot.all2p(spc.p, ghosts[0]) + pot.all2p(spc.p, ghosts[1]) + pot.p2p(ghosts[0], ghosts[1]);
+    expsum += exp(-du);
+  }
+  CHECK( widom.muex() == Approx( -log(expsum.avg()) / 2 ) );
+
+  // molecular insertions; weak system charges avoid overflow at close contact
+  for (auto &a : spc.p)
+    a.charge *= 1e-3;
+  spc.trial = spc.p;
+  Tmjson jm = { {"nstep", 1}, {"ninsert", 20}, {"parallel", true}, {"molecule", "multipoles"} };
+  Analysis::WidomMolecule<Tspace> wm(jm, potcell, spc);
+  eng = slump.eng;
+  for (int n=0; n<2; n++)
+    wm.sample();
+  slump.eng = eng;
+
+  RandomInserter<Tspace::MoleculeType> rins;
+  rins.dir = Point(1,1,1);
+  rins.checkOverlap = false;
+  Average<double> expu;
+  int molid = spc.molecule["multipoles"].id;
+  for (int n=0; n<2*20; n++) {
+    auto pin = rins(spc.geo, spc.p, spc.molecule[molid]);
+    expu += exp(-potcell.v2v(pin, spc.p));
+  }
+  CHECK( wm.expu.avg() == Approx( expu.avg() ) );
+}
+
+TEST_CASE("Debye histogram", "Compare histogram and pairwise Debye formula")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  InputMap in("unittests.json");
+  Tspace spc(in);
+  Tspace::ParticleVector p(300);
+  for (size_t i=0; i<p.size(); i++) {
+    spc.geo.randompos(p[i]);
+    p[i].id = i % 3 + 1;
+    p[i].radius = 0.5 + 0.5 * p[i].id;
+  }
+
+  for (double cutoff : {1.0e9, 4.0}) {
+    Tmjson j = { {"qmin", 0.1}, {"qmax", 1.0}, {"dq", 0.1}, {"cutoff", cutoff}, {"rbin", 0.001} };
+    Scatter::DebyeFormula<Scatter::FormFactorSphere<double>, Geometry::Sphere, double> exact(j);
+    j["histogram"] = true;
+    Scatter::DebyeFormula<Scatter::FormFactorSphere<double>, Geometry::Sphere, double> hist(j);
+    exact.sample(p, 1.0, spc.geo.getVolume());
+    hist.sample(p, 1.0, spc.geo.getVolume());
+    std::vector<double> ref;
+    for (auto &i : exact.I)
+      ref.push_back(i.second);
+    REQUIRE( hist.Ihist.size() == ref.size() );
+    for (size_t i=0; i<ref.size(); i++)
+      CHECK( hist.Ihist[i] == Approx( ref[i] ).epsilon(1e-3) );
+
+    // periodic boundaries: minimum image distances in both modes
+    j["histogram"] = false;
+    Scatter::DebyeFormula<Scatter::FormFactorSphere<double>, Geometry::Cuboid, double> pbc(j, spc.geo);
+    j["histogram"] = true;
+    Scatter::DebyeFormula<Scatter::FormFactorSphere<double>, Geometry::Cuboid, double> pbchist(j, spc.geo);
+    pbc.sample(p, 1.0, spc.geo.getVolume());
+    pbchist.sample(p, 1.0, spc.geo.getVolume());
+    REQUIRE( pbchist.Ihist.size() == pbc.I.size() );
+    size_t i = 0;
+    for (auto &k : pbc.I)
+      CHECK( pbchist.Ihist[i++] == Approx( k.second ).epsilon(1e-3) );
+  }
+}
+
+TEST_CASE("Pair sampler", "Compare single-pass multi-pair distance histograms with direct loops")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  InputMap in("unittests.json");
+  Tspace spc(in);
+  spc.p.resize(400);
+  for (size_t i=0; i<spc.p.size(); i++) {
+    spc.geo.randompos(spc.p[i]);
+    spc.p[i].id = i % 3;
+  }
+  auto type = [&](int i) { return int(spc.p[i].id); };
+  std::vector<std::array<int,2>> pairs = { {{0,1}}, {{1,1}}, {{2,0}} };
+
+  for (double rmax : {pc::infty, 5.0}) {
+    Analysis::PairSampler sampler;
+    for (auto &t : pairs)
+      sampler.add(t[0], t[1], 0.5, rmax);
+    sampler.sample(spc.geo, spc.p, type);
+
+    int cnt = 0;
+    sampler.forPairs(spc.geo, spc.p, type, [&](int, int, int, double) { cnt++; });
+
+    int total = 0;
+    for (size_t s=0; s<pairs.size(); s++) {
+      std::vector<double> h;
+      for (size_t i=0; i<spc.p.size()-1; i++)
+        for (size_t j=i+1; j<spc.p.size(); j++)
+          if ( (type(i)==pairs[s][0] && type(j)==pairs[s][1]) || (type(i)==pairs[s][1] && type(j)==pairs[s][0]) ) {
+            double r = spc.geo.dist(spc.p[i], spc.p[j]);
+            if (r <= rmax) {
+              size_t k = int(r / 0.5 + 0.5);
+              if (k >= h.size())
+                h.resize(k+1, 0);
+              h[k]++;
+              total++;
+            }
+          }
+      CHECK( sampler.histogram(s) == h );
+    }
+    CHECK( cnt == total );
+  }
+}
+
+TEST_CASE("Binned table", "Compare fixed-bin table with Table2D")
+{
+  auto read = [](const std::string &file) {
+    std::ifstream f(file);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    std::remove(file.c_str());
+    return ss.str();
+  };
+
+  for (auto key : {0, 1}) {
+    Table2D<double,double> ref(0.1, key==0 ? Table2D<double,double>::HISTOGRAM : Table2D<double,double>::XYDATA);
+    BinnedTable<double,double> a(0.1, key==0 ? BinnedTable<double,double>::HISTOGRAM : BinnedTable<double,double>::XYDATA);
+    BinnedTable<double,double> b(0.1), c(0.1);
+    b.reserve(-1, 1);
+    for (int n=0; n<2000; n++) {
+      double x = 8 * slump.half() + 1, y = slump();
+      ref(x) += y;
+      a(x) += y;
+      (n % 2 ? b : c)(x) += y;
+    }
+    b += c;
+    CHECK( a.size() == ref.getMap().size() );
+    CHECK( b.size() == a.size() );
+    CHECK( a.sumy() == Approx( ref.sumy() ) );
+    CHECK( b.sumy() == Approx( a.sumy() ) );
+    ref.save("binnedtable_ref.dat");
+    a.save("binnedtable_a.dat");
+    CHECK( read("binnedtable_ref.dat") == read("binnedtable_a.dat") );
+  }
+
+  Table2D<double,Average<double>> ref(0.2);
+  BinnedTable<double,Average<double>> avg(0.2);
+  for (int n=0; n<500; n++) {
+    double x = 5 * slump(), y = slump.half();
+    ref(x) += y;
+    avg(x) += y;
+  }
+  ref.save("binnedtable_ref.dat");
+  avg.save("binnedtable_a.dat");
+  CHECK( read("binnedtable_ref.dat") == read("binnedtable_a.dat") );
+}
+
+TEST_CASE("Async XTC", "Compare synchronous and background XTC output")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  InputMap in("unittests.json");
+  Tspace spc(in);
+  Tspace::ParticleVector p(50);
+  for (auto &a : p)
+    spc.geo.randompos(a);
+
+  auto read = [](const std::string &file) {
+    std::ifstream f(file, std::ios::binary);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    std::remove(file.c_str());
+    return ss.str();
+  };
+
+  {
+    FormatXTC xtc(1000);
+    FormatXTCAsync bounded(1000), unbounded(1000, 0);
+    for (int n=0; n<20; n++) {
+      for (auto &a : p)
+        a.translate(spc.geo, Point(slump.half(), slump.half(), slump.half()));
+      xtc.setbox( spc.geo.inscribe().len );
+      bounded.setbox( spc.geo.inscribe().len );
+      unbounded.setbox( spc.geo.inscribe().len );
+      CHECK( xtc.save("sync.xtc", p) );
+      CHECK( bounded.save("bounded.xtc", p) );
+      CHECK( unbounded.save("unbounded.xtc", p) );
+    }
+  }
+  std::string a = read("sync.xtc");
+  CHECK( a.empty() == false );
+  CHECK( a == read("bounded.xtc") );
+  CHECK( a == read("unbounded.xtc") );
+}
+
+TEST_CASE("Background analysis", "Compare inline and background analysis")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  typedef Potential::CutShift<Potential::Coulomb, false> Tpairpot;
+  InputMap in("unittests.json");
+  in["energy"]["nonbonded"]["cutoff"] = 3.0;
+  Tspace spc(in);
+  Tspace::ParticleVector salt(100);
+  for (size_t i=0; i<salt.size(); i++) {
+    salt[i] = atom[ i % 2 ? "Na" : "Cl" ];
+    spc.geo.randompos(salt[i]);
+  }
+  spc.insert(spc.molecule["salt"].id, salt);
+  spc.trial = spc.p;
+  Energy::Nonbonded<Tspace,Tpairpot> pot(in);
+  pot.setSpace(spc);
+
+  auto rdf = [](const string &file) -> Tmjson {
+    return { {"nstep", 2}, {"pairs", { { {"name1","Na"}, {"name2","Cl"}, {"dr",0.5}, {"file",file} } } } };
+  };
+  auto read = [](const std::string &file) {
+    std::ifstream f(file);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    std::remove(file.c_str());
+    return ss.str();
+  };
+
+  {
+    in["analysis"] = { {"atomrdf", rdf("rdf_inline.dat")}, {"_jsonfile", "analysis_inline.json"} };
+    Analysis::CombinedAnalysis inl(in, pot, spc);
+    in["analysis"] = { {"atomrdf", rdf("rdf_async.dat")}, {"_jsonfile", "analysis_async.json"},
+      {"_async", true}, {"_asyncbuffer", 2}, {"_asyncthreads", 2} };
+    size_t natoms = atom.size();
+    Analysis::CombinedAnalysis bg(in, pot, spc);
+    CHECK( atom.size() == natoms ); // shadow space must leave global atom types untouched
+    for (int n=0; n<40; n++) {
+      for (auto &a : spc.p)
+        a.translate(spc.geo, Point(slump.half(), slump.half(), slump.half()));
+      inl.sample();
+      bg.sample();
+    }
+    CHECK( bg.json().size() == inl.json().size() );
+  }
+  std::string a = read("rdf_inline.dat"), b = read("rdf_async.dat");
+  CHECK( a.empty() == false );
+  CHECK( a == b );
+  std::remove("analysis_inline.json");
+  std::remove("analysis_async.json");
+}
+
+TEST_CASE("Replica exchange", "Swap configurations between replicas in one process")
+{
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  typedef Potential::CutShift<Potential::Coulomb, false> Tpairpot;
+  typedef Energy::Nonbonded<Tspace,Tpairpot> Tenergy;
+  InputMap in("unittests.json");
+  in["energy"]["nonbonded"]["cutoff"] = 4.0;
+  Tmjson jt = { {"square", { {"dp", 2.0}, {"dprot", 1.0} } } };
+
+  std::vector<std::unique_ptr<Tspace>> spc;
+  std::vector<std::unique_ptr<Tenergy>> pot;
+  std::vector<std::unique_ptr<Move::TranslateRotate<Tspace>>> mv;
+  Move::ReplicaExchange<Tspace> rex;
+  std::vector<Point> len; // anisotropic boxes, exchanged with configurations
+  for (double epsr : {1.0, 4.0, 4.0}) { // last two replicas share Hamiltonian
+    in["energy"]["nonbonded"]["epsr"] = epsr;
+    spc.emplace_back( new Tspace(in) );
+    Tspace &s = *spc.back();
+    len.push_back( s.geo.len.cwiseProduct( Point(1.0 + 0.1*len.size(), 1.0, 1.0 + 0.03*len.size()) ) );
+    s.geo.setlen( len.back() );
+    auto &square = s.molecule[ s.molecule["square"].id ];
+    for (int n=0; n<4; n++)
+      s.insert(square.id, square.getRandomConformation(s.geo, s.p));
+    for (auto &a : s.p)
+      a.charge = slump.half();
+    s.trial = s.p;
+    pot.emplace_back( new Tenergy(in) );
+    mv.emplace_back( new Move::TranslateRotate<Tspace>(*pot.back(), s, jt) );
+    rex.add(s, *pot.back(), *mv.back());
+  }
+  CHECK( rex.size() == 3 );
+
+  rex.propagate(20);
+  std::vector<Tspace::ParticleVector> conf;
+  for (auto &s : spc)
+    conf.push_back(s->p);
+
+  for (int n=0; n<6; n++) {
+    auto w = rex.walkers();
+    int accepted = rex.exchange();
+    if (n % 2 == 1) { // odd pairs: 1 <-> 2 with identical Hamiltonians
+      CHECK( accepted == 1 );
+      CHECK( rex.walkers()[1] == w[2] );
+      CHECK( rex.walkers()[2] == w[1] );
+    }
+  }
+  auto w = rex.walkers();
+  std::sort(w.begin(), w.end());
+  CHECK( w == std::vector<int>({0, 1, 2}) );
+  for (size_t r=0; r<spc.size(); r++) {
+    CHECK( spc[r]->p == conf[ rex.walkers()[r] ] );
+    CHECK( spc[r]->trial == spc[r]->p );
+    CHECK( spc[r]->geo.len == len[ rex.walkers()[r] ] ); // exact, also after rejected swaps
+  }
+
+  // energy terms and caches holding configuration dependent data
+  {
+    typedef Space<Geometry::Cuboid, DipoleParticle> Tspace;
+    typedef Energy::NonbondedCellList<Tspace, Potential::CutShift<Potential::Coulomb, false>> Tcell;
+    typedef Energy::NonbondedEwald<Tspace, Potential::HardSphere> Tewald;
+    auto energy = [&]() -> Energy::Energybase<Tspace>& { return Tcell(in) + Tewald(in); };
+    std::vector<std::unique_ptr<Tspace>> spc;
+    std::vector<Energy::Energybase<Tspace>*> pot;
+    std::vector<std::unique_ptr<Energy::GroupPairCache<Tspace>>> cache;
+    std::vector<std::unique_ptr<Move::TranslateRotate<Tspace>>> mv;
+    Move::ReplicaExchange<Tspace> rex;
+    in["system"]["geometry"]["length"] = 30.0; // large enough for cells to pay off
+    for (double epsr : {1.0, 2.0}) {
+      in["energy"]["nonbonded"]["epsr"] = epsr;
+      spc.emplace_back( new Tspace(in) );
+      Tspace &s = *spc.back();
+      auto &square = s.molecule[ s.molecule["square"].id ];
+      for (int n=0; n<4; n++)
+        s.insert(square.id, square.getRandomConformation(s.geo, s.p));
+      Tspace::ParticleVector salt(100);
+      for (auto &a : salt) {
+        a = atom["Na"];
+        s.geo.randompos(a);
+      }
+      s.insert(s.molecule["salt"].id, salt);
+      for (auto &a : s.p) {
+        a.charge = slump.half();
+        a.radius = 0;
+      }
+      s.trial = s.p;
+      pot.push_back( &energy() );
+      pot.back()->setSpace(s);
+      cache.emplace_back( new Energy::GroupPairCache<Tspace>(*pot.back(), s) );
+      mv.emplace_back( new Move::TranslateRotate<Tspace>(*pot.back(), s, jt) );
+      mv.back()->setPairCache(*cache.back());
+      rex.add(s, *pot.back(), *mv.back());
+    }
+    rex.propagate(20);
+    for (int n=0; n<4; n++) {
+      rex.exchange();
+      for (size_t r=0; r<spc.size(); r++) {
+        Tspace &s = *spc[r];
+        in["energy"]["nonbonded"]["epsr"] = (r==0) ? 1.0 : 2.0;
+        auto &fresh = energy();
+        double u = Energy::systemEnergy(s, fresh, s.p);
+        CHECK( Energy::systemEnergy(s, *pot[r], s.p) == Approx(u) );
+        CHECK( Energy::cachedSystemEnergy(s, *pot[r], *cache[r]) == Approx(u) );
+        delete &fresh;
+      }
+      rex.propagate(5);
+    }
+  }
+}
+
+TEST_CASE("Running energy", "Compare running total energy with full evaluation")
+{
+  int calls = 0;
+  double ufull = 10;
+  Energy::RunningEnergy r([&]() { calls++; return ufull; }, 3);
+  r.add(1.0);                    // ignored until first evaluation
+  CHECK( r.current() == Approx(10) );
+  CHECK( calls == 1 );
+  r.add(1.0);
+  r.add(0.5);
+  CHECK( r.current() == Approx(11.5) );
+  CHECK( calls == 1 );
+  ufull = 11.6;
+  r.add(0.0);                    // third change triggers resync
+  CHECK( calls == 2 );
+  CHECK( r.current() == Approx(11.6) );
+  CHECK( r.maxDrift() == Approx(0.1) );
+
+  typedef Space<Geometry::Cuboid, PointParticle> Tspace;
+  typedef Potential::CutShift<Potential::Coulomb, false> Tpairpot;
+  InputMap in("unittests.json");
+  in["energy"]["nonbonded"]["cutoff"] = 4.0;
+  in["moves"] = { {"moltransrot", { {"square", { {"dp", 2.0}, {"dprot", 1.0} } } } }, {"_resync", 7}, {"_jsonfile", ""} };
+  Tspace spc(in);
+  auto &square = spc.molecule[ spc.molecule["square"].id ];
+  for (int n=0; n<5; n++)
+    spc.insert(square.id, square.getRandomConformation(spc.geo, spc.p));
+  for (auto &a : spc.p)
+    a.charge = slump.half();
+  spc.trial = spc.p;
+  Energy::Nonbonded<Tspace,Tpairpot> pot(in);
+  Move::Propagator<Tspace> mv(in, pot, spc);
+  CHECK( mv.runningEnergy().resyncInterval == 7 );
+
+  double u0 = Energy::systemEnergy(spc, pot, spc.p), du = 0;
+  for (int n=0; n<30; n++) {
+    du += mv.move();
+    CHECK( mv.runningEnergy().current() == Approx( Energy::systemEnergy(spc, pot, spc.p) ) );
+  }
+  CHECK( mv.runningEnergy().current() == Approx(u0 + du) );
+  CHECK( mv.runningEnergy().maxDrift() < 1e-6 );
+}
+
 TEST_CASE("Groups", "Check group range and size properties")
 {
   Group g(2,5);           // first, last particle
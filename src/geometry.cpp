@@ -512,6 +512,104 @@ namespace Faunus
         allowMatterOverlap = false;
     }
 
+    CellList::CellList() : n(1, 1, 1), rc(0) {}
+
+    /**
+     * @param length Container side lengths
+     * @param cutoff Minimum cell side length
+     * @param periodic Periodicity in x, y, and z
+     */
+    void CellList::setup( const Point &length, double cutoff, const std::array<bool, 3> &periodic )
+    {
+        assert(cutoff > 0 && "Cell list cutoff must be positive");
+        rc = cutoff;
+        len_half = 0.5 * length;
+        for ( int d = 0; d < 3; d++ )
+        {
+            n[d] = std::max(int(length[d] / cutoff), 1);
+            cellinv[d] = n[d] / length[d];
+        }
+        cells.assign(n.prod(), std::vector<int>());
+        neighbours.assign(n.prod(), std::vector<int>());
+
+        // neighbouring cells are pre-calculated; duplicates may appear
+        // for small grids (n<3) and are removed to avoid double counting
+        for ( int x = 0; x < n[0]; x++ )
+            for ( int y = 0; y < n[1]; y++ )
+                for ( int z = 0; z < n[2]; z++ )
+                {
+                    Eigen::Vector3i c(x, y, z);
+                    auto &v = neighbours[c[0] + n[0] * (c[1] + n[1] * c[2])];
+                    for ( int dx = -1; dx <= 1; dx++ )
+                        for ( int dy = -1; dy <= 1; dy++ )
+                            for ( int dz = -1; dz <= 1; dz++ )
+                            {
+                                Eigen::Vector3i k = c + Eigen::Vector3i(dx, dy, dz);
+                                bool outside = false;
+                                for ( int d = 0; d < 3; d++ )
+                                    if ( k[d] < 0 || k[d] >= n[d] )
+                                    {
+                                        if ( periodic[d] )
+                                            k[d] = (k[d] + n[d]) % n[d];
+                                        else
+                                            outside = true;
+                                    }
+                                if ( !outside )
+                                    v.push_back(k[0] + n[0] * (k[1] + n[1] * k[2]));
+                            }
+                    std::sort(v.begin(), v.end());
+                    v.erase(std::unique(v.begin(), v.end()), v.end());
+                }
+        cellOf.clear();
+        slot.clear();
+    }
+
+    void CellList::add( int i, int c )
+    {
+        cellOf[i] = c;
+        slot[i] = cells[c].size();
+        cells[c].push_back(i);
+    }
+
+    void CellList::remove( int i )
+    {
+        auto &v = cells[cellOf[i]];
+        int j = v.back(); // move last element into vacant slot
+        v[slot[i]] = j;
+        slot[j] = slot[i];
+        v.pop_back();
+    }
+
+    void CellList::update( int i, const Point &a )
+    {
+        assert(i >= 0 && i < (int) cellOf.size());
+        int c = index(a);
+        if ( c != cellOf[i] )
+        {
+            remove(i);
+            add(i, c);
+        }
+    }
+
+    void CellList::clear()
+    {
+        for ( auto &c : cells )
+            c.clear();
+        cellOf.clear();
+        slot.clear();
+    }
+
+    double CellList::averageNeighbours() const
+    {
+        if ( cells.empty())
+            return 0;
+        double sum = 0;
+        for ( auto &v : neighbours )
+            for ( auto c : v )
+                sum += cells[c].size();
+        return sum / cells.size();
+    }
+
     CuboidNoPBC::CuboidNoPBC( ) { name += " (No PBC)"; }
 
     CuboidNoPBC::CuboidNoPBC( Tmjson &j ) : Cuboid(j) { name += " (No PBC)"; }
@@ -17,7 +17,7 @@ int main() {
   cout << spc.info() + pot.info() + mv.info(); // final information
 
   Energy::Manybody<Tspace> three(spc);
-  three.add( Potential::Angular( {0,1,2}, 30., 0.5 ) );
-  cout << three.external(spc.p) << endl;
+  three.addAngle( 0, 1, 2, 0.5, 30. );
+  cout << Energy::systemEnergy(spc, three, spc.p) << endl; // intra- and inter-group terms
   cout << three.info();
 }